@@ -0,0 +1,441 @@
+#include "ArchiveSource.h"
+#include "StreamingConverter.h"
+#include <cstring>
+
+namespace
+{
+    // ── ZIP ─────────────────────────────────────────────────────────────────
+    // Read by hand rather than through juce::ZipFile, which only understands
+    // the 32-bit directory and so cannot see into multi-GB bundles.
+    constexpr juce::uint32 kZipEndSig       = 0x06054b50;
+    constexpr juce::uint32 kZip64EndSig     = 0x06064b50;
+    constexpr juce::uint32 kZip64LocatorSig = 0x07064b50;
+    constexpr juce::uint32 kZipCentralSig   = 0x02014b50;
+    constexpr juce::uint32 kZipLocalSig     = 0x04034b50;
+    constexpr int          kZipEndLen       = 22;
+    constexpr int          kZipLocatorLen   = 20;
+    constexpr int          kZipCentralLen   = 46;
+    constexpr int          kZipLocalLen     = 30;
+    constexpr juce::int64  kZipSaturated    = 0xffffffff;
+
+    juce::uint32 le16 (const juce::uint8* p)  { return juce::ByteOrder::littleEndianShort (p); }
+    juce::uint32 le32 (const juce::uint8* p)  { return juce::ByteOrder::littleEndianInt (p); }
+    juce::int64  le64 (const juce::uint8* p)  { return juce::int64 (juce::ByteOrder::littleEndianInt64 (p)); }
+
+    // Walks the central directory, calling fn (name, location) for every file
+    // entry that can be read (stored or deflated, not encrypted, not a
+    // symlink) until fn returns false. Returns a message if the directory
+    // itself cannot be read.
+    template <typename Fn>
+    juce::String forEachZipEntry (const juce::File& archive, Fn&& fn)
+    {
+        const juce::String damaged = "Damaged ZIP directory";
+
+        juce::FileInputStream in (archive);
+        if (in.failedToOpen())
+            return "Cannot open the archive";
+
+        // The end record is the last thing in the file, followed only by a
+        // comment of up to 64 KB; a ZIP64 locator sits right before it
+        const juce::int64 total   = in.getTotalLength();
+        const int         tailLen = int (juce::jmin (total, juce::int64 (kZipLocatorLen + kZipEndLen + 0xffff)));
+        juce::HeapBlock<juce::uint8> tail (tailLen);
+
+        if (tailLen < kZipEndLen || !in.setPosition (total - tailLen) || in.read (tail.get(), tailLen) != tailLen)
+            return "Not a ZIP archive";
+
+        int endPos = -1;
+        for (int i = tailLen - kZipEndLen; i >= 0 && endPos < 0; --i)
+            if (le32 (tail + i) == kZipEndSig)
+                endPos = i;
+
+        if (endPos < 0)
+            return "Not a ZIP archive";
+
+        const juce::uint8* end = tail + endPos;
+        bool        split      = le16 (end + 4) != 0 || le16 (end + 6) != 0;
+        juce::int64 numEntries = le16 (end + 10);
+        juce::int64 dirSize    = le32 (end + 12);
+        juce::int64 dirOffset  = le32 (end + 16);
+
+        if (endPos >= kZipLocatorLen && le32 (end - kZipLocatorLen) == kZip64LocatorSig)
+        {
+            juce::uint8 rec[56];
+            if (!in.setPosition (le64 (end - kZipLocatorLen + 8))
+                || in.read (rec, sizeof (rec)) != int (sizeof (rec))
+                || le32 (rec) != kZip64EndSig)
+                return damaged;
+
+            split      = le32 (rec + 16) != 0 || le32 (rec + 20) != 0;
+            numEntries = le64 (rec + 32);
+            dirSize    = le64 (rec + 40);
+            dirOffset  = le64 (rec + 48);
+        }
+
+        if (split)
+            return "Split ZIP archives are not supported";
+
+        juce::MemoryBlock dir;
+        if (dirOffset < 0 || dirSize < 0 || dirOffset + dirSize > total || dirSize > (juce::int64 (1) << 30)
+            || !in.setPosition (dirOffset)
+            || in.readIntoMemoryBlock (dir, juce::ssize_t (dirSize)) != size_t (dirSize))
+            return damaged;
+
+        const auto*  d   = static_cast<const juce::uint8*> (dir.getData());
+        const size_t len = dir.getSize();
+        size_t       pos = 0;
+
+        for (juce::int64 i = 0; i < numEntries; ++i)
+        {
+            if (pos + kZipCentralLen > len || le32 (d + pos) != kZipCentralSig)
+                return damaged;
+
+            const juce::uint8* h = d + pos;
+            const int nameLen    = int (le16 (h + 28));
+            const int extraLen   = int (le16 (h + 30));
+            const int commentLen = int (le16 (h + 32));
+
+            if (pos + size_t (kZipCentralLen + nameLen + extraLen + commentLen) > len)
+                return damaged;
+
+            const juce::uint32 flags  = le16 (h + 8);
+            const juce::uint32 method = le16 (h + 10);
+            juce::int64 storedSize = le32 (h + 20);
+            juce::int64 size       = le32 (h + 24);
+            juce::int64 offset     = le32 (h + 42);
+
+            // ZIP64 extra field: 64-bit values for the saturated fields above, in this order
+            const juce::uint8* extra = h + kZipCentralLen + nameLen;
+            for (int e = 0; e + 4 <= extraLen;)
+            {
+                const int id     = int (le16 (extra + e));
+                const int extLen = int (le16 (extra + e + 2));
+                if (e + 4 + extLen > extraLen)
+                    break;
+
+                if (id == 0x0001)
+                {
+                    const juce::uint8* f = extra + e + 4;
+                    int used = 0;
+                    for (auto* v : { &size, &storedSize, &offset })
+                    {
+                        if (*v == kZipSaturated && used + 8 <= extLen)
+                        {
+                            *v = le64 (f + used);
+                            used += 8;
+                        }
+                    }
+                }
+                e += 4 + extLen;
+            }
+
+            const auto name = juce::String::fromUTF8 (reinterpret_cast<const char*> (h + kZipCentralLen), nameLen);
+            const bool unixSymlink = (le16 (h + 4) >> 8) == 3 && ((le32 (h + 38) >> 16) & 0170000) == 0120000;
+            pos += size_t (kZipCentralLen + nameLen + extraLen + commentLen);
+
+            if (name.endsWithChar ('/') || unixSymlink || (flags & 1) != 0 || (method != 0 && method != 8))
+                continue;
+
+            if (!fn (name, ArchiveLocation { offset, storedSize, size, method == 8 }))
+                break;
+        }
+
+        return {};
+    }
+
+    std::unique_ptr<juce::InputStream> openZipEntry (const juce::File& archive, const ArchiveLocation& loc)
+    {
+        auto file = std::make_unique<juce::FileInputStream> (archive);
+        juce::uint8 local[kZipLocalLen];
+
+        if (file->failedToOpen() || !file->setPosition (loc.offset)
+            || file->read (local, kZipLocalLen) != kZipLocalLen || le32 (local) != kZipLocalSig)
+            return nullptr;
+
+        // Name and extra field lengths here can differ from the central directory's
+        const juce::int64 dataPos = loc.offset + kZipLocalLen + le16 (local + 26) + le16 (local + 28);
+        auto window = std::make_unique<juce::SubregionStream> (file.release(), dataPos, loc.storedSize, true);
+
+        if (!loc.compressed)
+            return window;
+
+        return std::make_unique<juce::GZIPDecompressorInputStream> (window.release(), true,
+                                                                    juce::GZIPDecompressorInputStream::deflateFormat,
+                                                                    loc.size);
+    }
+
+    // Reads a WAV strictly front to back. JUCE's WAV reader walks the chunks
+    // after `data` and then seeks back to the samples, which on an inflating
+    // stream means decompressing the entry twice.
+    class ForwardWavReader : public juce::AudioFormatReader
+    {
+    public:
+        explicit ForwardWavReader (juce::InputStream* source)
+            : juce::AudioFormatReader (source, "WAV"), wav (*source) {}
+
+        bool parseHeader()
+        {
+            if (!wav.parseHeader())
+                return false;
+
+            sampleRate            = wav.sampleRate;
+            numChannels           = unsigned (wav.numChannels);
+            bitsPerSample         = unsigned (wav.bitsPerSample);
+            usesFloatingPointData = true;   // readSamples hands out floats
+
+            const juce::int64 bytesPerFrame = juce::int64 (wav.numChannels) * (wav.bitsPerSample / 8);
+            lengthInSamples = (wav.dataBytes >= 0 ? wav.dataBytes
+                                                  : input->getTotalLength() - input->getPosition()) / bytesPerFrame;
+            return true;
+        }
+
+        bool readSamples (int* const* destChannels, int numDestChannels, int startOffsetInDestBuffer,
+                          juce::int64 startSampleInFile, int numSamples) override
+        {
+            // Going back would mean inflating from the start again
+            if (startSampleInFile < position)
+                return false;
+
+            while (position < startSampleInFile)
+                if (decode (int (juce::jmin (juce::int64 (kChunk), startSampleInFile - position))) == 0)
+                    break;
+
+            int done = 0;
+            while (done < numSamples)
+            {
+                const int n = decode (numSamples - done);
+                if (n == 0)
+                    break;
+
+                for (int ch = 0; ch < juce::jmin (numDestChannels, int (numChannels)); ++ch)
+                    if (destChannels[ch] != nullptr)
+                        std::memcpy (reinterpret_cast<float*> (destChannels[ch]) + startOffsetInDestBuffer + done,
+                                     scratch.getReadPointer (ch), size_t (n) * sizeof (float));
+                done += n;
+            }
+
+            // Past the end of the data: silence
+            for (int ch = 0; ch < numDestChannels; ++ch)
+                if (destChannels[ch] != nullptr)
+                    juce::FloatVectorOperations::clear (reinterpret_cast<float*> (destChannels[ch]) + startOffsetInDestBuffer + done,
+                                                        numSamples - done);
+            return true;
+        }
+
+    private:
+        static constexpr int kChunk = 8192;
+
+        int decode (int maxFrames)
+        {
+            scratch.setSize (int (numChannels), kChunk, false, false, true);
+            const int n = wav.readFrames (scratch, 0, juce::jmin (maxFrames, kChunk));
+            position += n;
+            return n;
+        }
+
+        StreamingWavReader       wav;
+        juce::AudioBuffer<float> scratch;
+        juce::int64              position { 0 };   // next frame the stream will deliver
+    };
+
+    // ── TAR ─────────────────────────────────────────────────────────────────
+    constexpr int kTarBlock = 512;
+
+    juce::int64 parseTarNumber (const char* field, int len)
+    {
+        // GNU base-256 encoding, used for entries of 8 GB and more
+        if ((static_cast<unsigned char> (field[0]) & 0x80) != 0)
+        {
+            juce::int64 v = static_cast<unsigned char> (field[0]) & 0x7f;
+            for (int i = 1; i < len; ++i)
+                v = (v << 8) | static_cast<unsigned char> (field[i]);
+            return v;
+        }
+
+        juce::int64 v = 0;
+        for (int i = 0; i < len && field[i] != 0; ++i)
+            if (field[i] >= '0' && field[i] <= '7')
+                v = (v << 3) + (field[i] - '0');
+        return v;
+    }
+
+    juce::String tarString (const char* field, int len)
+    {
+        int n = 0;
+        while (n < len && field[n] != 0)
+            ++n;
+        return juce::String::fromUTF8 (field, n);
+    }
+
+    // Walks the headers of a tar file, calling fn (name, location) for every
+    // regular file until fn returns false. Handles ustar prefixes, GNU long
+    // names ('L') and pax 'path' records ('x'). Returns a message if the
+    // archive cannot be opened.
+    template <typename Fn>
+    juce::String forEachTarEntry (const juce::File& archive, Fn&& fn)
+    {
+        juce::FileInputStream in (archive);
+        if (in.failedToOpen())
+            return "Cannot open the archive";
+
+        const juce::int64 total = in.getTotalLength();
+        juce::int64 pos = 0;
+        juce::String pendingName;
+        char h[kTarBlock];
+
+        while (pos + kTarBlock <= total)
+        {
+            if (!in.setPosition (pos) || in.read (h, kTarBlock) != kTarBlock)
+                break;
+
+            if (h[0] == 0)
+                break; // end-of-archive marker
+
+            const juce::int64 size     = parseTarNumber (h + 124, 12);
+            const char        type     = h[156];
+            const juce::int64 dataPos  = pos + kTarBlock;
+            const juce::int64 nextPos  = dataPos + ((size + kTarBlock - 1) / kTarBlock) * kTarBlock;
+
+            if (type == 'L' || type == 'x')
+            {
+                juce::MemoryBlock mb;
+                in.setPosition (dataPos);
+                in.readIntoMemoryBlock (mb, juce::ssize_t (juce::jmin (size, juce::int64 (1 << 20))));
+
+                if (type == 'L')
+                {
+                    pendingName = tarString (static_cast<const char*> (mb.getData()), int (mb.getSize()));
+                }
+                else
+                {
+                    for (auto& rec : juce::StringArray::fromLines (mb.toString()))
+                        if (rec.fromFirstOccurrenceOf (" ", false, false).startsWith ("path="))
+                            pendingName = rec.fromFirstOccurrenceOf ("path=", false, false);
+                }
+            }
+            else
+            {
+                juce::String name = pendingName;
+                pendingName.clear();
+
+                if (name.isEmpty())
+                {
+                    name = tarString (h, 100);
+                    if (tarString (h + 257, 5) == "ustar")
+                        if (auto prefix = tarString (h + 345, 155); prefix.isNotEmpty())
+                            name = prefix + "/" + name;
+                }
+
+                if ((type == '0' || type == 0) && !fn (name, ArchiveLocation { dataPos, size, size, false }))
+                    break;
+            }
+
+            pos = nextPos;
+        }
+
+        return {};
+    }
+}
+
+namespace ArchiveSource
+{
+bool isArchive (const juce::File& f)
+{
+    return f.hasFileExtension ("zip;tar");
+}
+
+juce::Array<Entry> listWavEntries (const juce::File& archive, juce::String& error)
+{
+    juce::Array<Entry> entries;
+
+    auto addWav = [&entries] (const juce::String& name, const ArchiveLocation& location)
+    {
+        if (name.endsWithIgnoreCase (".wav"))
+            entries.add ({ name, location });
+        return true;
+    };
+
+    if (archive.hasFileExtension ("zip"))
+        error = forEachZipEntry (archive, addWav);
+    else if (archive.hasFileExtension ("tar"))
+        error = forEachTarEntry (archive, addWav);
+    else
+        error = "Not a .zip or .tar archive";
+
+    if (error.isNotEmpty())
+        entries.clear();
+
+    return entries;
+}
+
+std::unique_ptr<juce::InputStream> openEntry (const juce::File&   archive,
+                                              const juce::String& entryName)
+{
+    ArchiveLocation found;
+
+    auto match = [&] (const juce::String& name, const ArchiveLocation& location)
+    {
+        if (name != entryName)
+            return true;
+        found = location;
+        return false;
+    };
+
+    if (archive.hasFileExtension ("zip"))
+        forEachZipEntry (archive, match);
+    else if (archive.hasFileExtension ("tar"))
+        forEachTarEntry (archive, match);
+
+    if (found.offset < 0)
+        return nullptr;
+
+    return openEntry (archive, found);
+}
+
+std::unique_ptr<juce::InputStream> openEntry (const juce::File&      archive,
+                                              const ArchiveLocation& location)
+{
+    if (location.offset < 0)
+        return nullptr;
+
+    if (archive.hasFileExtension ("zip"))
+        return openZipEntry (archive, location);
+
+    if (archive.hasFileExtension ("tar"))
+    {
+        auto file = std::make_unique<juce::FileInputStream> (archive);
+        if (file->failedToOpen())
+            return nullptr;
+
+        // Tar entries are stored contiguously, so the entry is a seekable window
+        return std::make_unique<juce::SubregionStream> (file.release(), location.offset, location.storedSize, true);
+    }
+
+    return nullptr;
+}
+
+std::unique_ptr<juce::InputStream> openInput (const ConversionJob& job)
+{
+    // Jobs queued from a listing know where their entry is; others (service requests) look it up
+    if (job.archiveEntry.isNotEmpty())
+        return job.archiveLocation.offset >= 0 ? openEntry (job.inputFile, job.archiveLocation)
+                                               : openEntry (job.inputFile, job.archiveEntry);
+
+    return job.inputFile.createInputStream();
+}
+
+std::unique_ptr<juce::AudioFormatReader> createReader (juce::AudioFormatManager&          formats,
+                                                       std::unique_ptr<juce::InputStream> in)
+{
+    if (in == nullptr)
+        return nullptr;
+
+    if (dynamic_cast<juce::GZIPDecompressorInputStream*> (in.get()) == nullptr)
+        return std::unique_ptr<juce::AudioFormatReader> (formats.createReaderFor (std::move (in)));
+
+    auto reader = std::make_unique<ForwardWavReader> (in.release());
+    if (!reader->parseHeader())
+        return nullptr;
+    return reader;
+}
+}
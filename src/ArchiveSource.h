@@ -0,0 +1,45 @@
+#pragma once
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_core/juce_core.h>
+#include "ConversionJob.h"
+#include <memory>
+
+// Reads WAV entries straight out of .zip and .tar bundles, without extracting
+// them to disk. Every opened entry gets its own file handle, so several
+// workers can stream different entries of the same archive at once.
+//
+// ZIP: stored and deflated entries, including ZIP64 archives (over 4 GB or
+// 65535 entries). Encrypted entries and split archives are not supported.
+namespace ArchiveSource
+{
+    struct Entry
+    {
+        juce::String    name;       // relative path inside the archive
+        ArchiveLocation location;
+    };
+
+    bool isArchive (const juce::File& f);
+
+    // All .wav entries, in archive order. If the archive cannot be read,
+    // returns nothing and sets error.
+    juce::Array<Entry> listWavEntries (const juce::File& archive, juce::String& error);
+
+    // Looks the entry up by name. Returns nullptr if the archive or entry
+    // cannot be opened.
+    std::unique_ptr<juce::InputStream> openEntry (const juce::File&   archive,
+                                                  const juce::String& entryName);
+
+    // Opens an entry at a location returned by listWavEntries.
+    std::unique_ptr<juce::InputStream> openEntry (const juce::File&      archive,
+                                                  const ArchiveLocation& location);
+
+    // Opens the job's source, whether a loose file or an archive entry.
+    std::unique_ptr<juce::InputStream> openInput (const ConversionJob& job);
+
+    // Reader for a stream from openInput. Deflated entries can only be read
+    // front to back without inflating them again, so they get a WAV reader
+    // that parses the header up to the data chunk and then reads forward;
+    // everything else goes through formats.
+    std::unique_ptr<juce::AudioFormatReader> createReader (juce::AudioFormatManager&          formats,
+                                                           std::unique_ptr<juce::InputStream> in);
+}
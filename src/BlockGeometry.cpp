@@ -0,0 +1,277 @@
+#include "BlockGeometry.h"
+#include "FileConverter.h"
+#include "ResourceGovernor.h"
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    constexpr int    kBlockCandidates[]  { 1024, 2048, 4096, 8192, 16384, 32768, 65536 };
+    constexpr int    kBufferCandidates[] { 16384, 65536, 262144, 1048576 };
+    constexpr int    kChannelClasses[]   { 2, 6, 16 };    // one representative per bucket
+    constexpr int    kBitClasses[]       { 16, 24 };
+    constexpr double kSampleRate         = 48000.0;
+    constexpr double kSeconds            = 6.0;
+    constexpr int    kRuns               = 3;             // best of, to ride out scheduler noise
+
+    // A profile only applies to the CPU it was measured on
+    juce::String machineId()
+    {
+        return juce::SystemStats::getCpuModel().trim() + " x" + juce::String (juce::SystemStats::getNumCpus());
+    }
+
+    struct Cache
+    {
+        juce::CriticalSection lock;
+        juce::Time            loadedModTime;   // of the profile file; reloaded when it changes
+        bool                  loaded { false };
+        juce::var             classes;
+    };
+
+    Cache& cache()
+    {
+        static Cache c;
+        return c;
+    }
+
+    BlockGeometry fromVar (const juce::var& v)
+    {
+        BlockGeometry g;
+        if (auto* obj = v.getDynamicObject())
+        {
+            g.blockFrames      = juce::jlimit (256, 1 << 17, int (obj->getProperty ("blockFrames")));
+            g.writeBufferBytes = juce::jlimit (4096, 1 << 24, int (obj->getProperty ("writeBufferBytes")));
+        }
+        return g;
+    }
+
+    juce::var toVar (const BlockGeometry& g)
+    {
+        auto* obj = new juce::DynamicObject();
+        obj->setProperty ("blockFrames", g.blockFrames);
+        obj->setProperty ("writeBufferBytes", g.writeBufferBytes);
+        return juce::var (obj);
+    }
+
+    // Tones plus low-level noise: compressible enough that FLAC's predictor
+    // does real work, random enough that it can't collapse to constant frames.
+    bool writeSyntheticWav (const juce::File& file, int numCh, int bits)
+    {
+        file.deleteFile();
+        auto stream = std::make_unique<juce::FileOutputStream> (file);
+        if (stream->failedToOpen())
+            return false;
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer (
+            wav.createWriterFor (stream.get(), kSampleRate, unsigned (numCh), bits, {}, 0));
+        if (writer == nullptr)
+            return false;
+        stream.release(); // writer now owns the stream
+
+        juce::Random rng (0x77a5);
+        const int numFrames = int (kSampleRate * kSeconds);
+        const int chunk     = 8192;
+        juce::AudioBuffer<float> buf (numCh, chunk);
+
+        for (int pos = 0; pos < numFrames; pos += chunk)
+        {
+            const int n = juce::jmin (chunk, numFrames - pos);
+            for (int ch = 0; ch < numCh; ++ch)
+            {
+                const double freq = 110.0 * (ch + 1);
+                auto* d = buf.getWritePointer (ch);
+                for (int i = 0; i < n; ++i)
+                    d[i] = 0.5f * float (std::sin (juce::MathConstants<double>::twoPi * freq * (pos + i) / kSampleRate))
+                         + 0.05f * (rng.nextFloat() * 2.0f - 1.0f);
+            }
+
+            if (!writer->writeFromAudioSampleBuffer (buf, 0, n))
+                return false;
+        }
+        return true;
+    }
+
+    // Best wall time of kRuns conversions with the given geometry, or -1 on failure.
+    // Two outputs, one of them resampled, so the resampler and the branch pool
+    // are part of what is measured.
+    double timeConversion (FileConverter& converter, const juce::File& wavFile, const BlockGeometry& g)
+    {
+        converter.setGeometryOverride (g);
+
+        ConversionSettings resampled;
+        resampled.targetSampleRate = 44100;
+        resampled.outputSuffix     = "_44k";
+
+        juce::Array<ConversionSettings> profiles;
+        profiles.add ({});
+        profiles.add (resampled);
+
+        double best = std::numeric_limits<double>::max();
+        for (int run = 0; run < kRuns; ++run)
+        {
+            ConversionJob    job { wavFile };
+            ResourceGovernor governor { ResourceLimits() };
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            if (!converter.convert (job, profiles, governor, [] { return false; }, {}))
+                return -1.0;
+            best = juce::jmin (best, juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start));
+        }
+        return best;
+    }
+}
+
+namespace BlockGeometryProfile
+{
+    juce::String classFor (int numChannels, int bitsPerSample)
+    {
+        const char* width = numChannels <= 2 ? "stereo"
+                          : numChannels <= 8 ? "multi"
+                                             : "wide";
+        return juce::String (width) + (bitsPerSample <= 16 ? "-16" : "-24");
+    }
+
+    juce::File getProfileFile()
+    {
+        return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                   .getChildFile ("Wav2FlacYeah")
+                   .getChildFile ("block-geometry.json");
+    }
+
+    BlockGeometry lookup (int numChannels, int bitsPerSample)
+    {
+        auto& c = cache();
+        const juce::ScopedLock sl (c.lock);
+
+        // A long-running service picks up a later --calibrate without a restart
+        const auto file    = getProfileFile();
+        const auto modTime = file.getLastModificationTime();
+
+        if (!c.loaded || modTime != c.loadedModTime)
+        {
+            c.loaded        = true;
+            c.loadedModTime = modTime;
+            c.classes       = {};
+
+            const auto profile = juce::JSON::parse (file);
+            if (profile.getProperty ("machine", {}).toString() == machineId())
+                c.classes = profile.getProperty ("classes", {});
+        }
+
+        const auto entry = c.classes.getProperty (juce::Identifier (classFor (numChannels, bitsPerSample)), {});
+        return entry.isObject() ? fromVar (entry) : BlockGeometry();
+    }
+
+    std::optional<juce::File> parseCalibrateCommandLine (const juce::StringArray& args)
+    {
+        const int idx = args.indexOf ("--calibrate");
+        if (idx < 0)
+            return std::nullopt;
+
+        if (idx + 1 < args.size() && !args[idx + 1].startsWith ("-"))
+            return juce::File::getCurrentWorkingDirectory().getChildFile (args[idx + 1]);
+
+        // Not the temp directory: that is often tmpfs, where buffer sizes only measure memcpy
+        return juce::File::getSpecialLocation (juce::File::userHomeDirectory);
+    }
+
+    bool calibrate (const juce::File& directory, const std::function<void (const juce::String&)>& log)
+    {
+        auto workDir = directory.getNonexistentChildFile (".wav2flac-calibrate", {}, false);
+        if (!workDir.createDirectory())
+        {
+            log ("Cannot create " + workDir.getFullPathName());
+            return false;
+        }
+
+        log ("Calibrating block geometry on " + machineId() + " in " + directory.getFullPathName());
+
+        // Set up like the GUI worker, so multi-output runs are measured as they really run
+        juce::ThreadPool branchPool (juce::ThreadPoolOptions{}
+                                         .withThreadName ("Wav2FlacYeah Calibrate Branch")
+                                         .withNumberOfThreads (juce::jmax (1, juce::SystemStats::getNumCpus() - 1)));
+        FileConverter converter (&branchPool);
+        juce::DynamicObject::Ptr classes (new juce::DynamicObject());
+        bool ok = true;
+
+        for (int numCh : kChannelClasses)
+        {
+            for (int bits : kBitClasses)
+            {
+                const auto name    = classFor (numCh, bits);
+                const auto wavFile = workDir.getChildFile (name + ".wav");
+
+                if (!writeSyntheticWav (wavFile, numCh, bits))
+                {
+                    log (name + ": cannot write test audio");
+                    ok = false;
+                    continue;
+                }
+
+                // Block size first at the default buffer, then the buffer at that block size
+                BlockGeometry best;
+                double bestSeconds = std::numeric_limits<double>::max();
+
+                auto tryGeometry = [&] (const BlockGeometry& g)
+                {
+                    const double secs = timeConversion (converter, wavFile, g);
+                    if (secs >= 0.0 && secs < bestSeconds)
+                    {
+                        bestSeconds = secs;
+                        best        = g;
+                    }
+                };
+
+                for (int frames : kBlockCandidates)
+                    tryGeometry ({ frames, BlockGeometry().writeBufferBytes });
+
+                const int bestFrames = best.blockFrames;
+                for (int bytes : kBufferCandidates)
+                    tryGeometry ({ bestFrames, bytes });
+
+                if (bestSeconds == std::numeric_limits<double>::max())
+                {
+                    log (name + ": conversion failed");
+                    ok = false;
+                    continue;
+                }
+
+                log (name + ": " + juce::String (best.blockFrames) + " frames, "
+                     + juce::String (best.writeBufferBytes / 1024) + " KB write buffer ("
+                     + juce::String (kSeconds / bestSeconds, 1) + "x realtime)");
+                classes->setProperty (juce::Identifier (name), toVar (best));
+            }
+        }
+
+        workDir.deleteRecursively();
+
+        if (!ok)
+            return false;
+
+        auto* profile = new juce::DynamicObject();
+        profile->setProperty ("machine", machineId());
+        profile->setProperty ("classes", juce::var (classes.get()));
+        const juce::var profileVar (profile);
+
+        const auto file = getProfileFile();
+        file.getParentDirectory().createDirectory();
+        if (!file.replaceWithText (juce::JSON::toString (profileVar)))
+        {
+            log ("Cannot write " + file.getFullPathName());
+            return false;
+        }
+
+        {
+            auto& c = cache();
+            const juce::ScopedLock sl (c.lock);
+            c.loaded        = true;
+            c.loadedModTime = file.getLastModificationTime();
+            c.classes       = profileVar.getProperty ("classes", {});
+        }
+
+        log ("Saved " + file.getFullPathName());
+        return true;
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <functional>
+#include <optional>
+
+// Buffer sizes for the read → resample → encode → write pipeline.
+struct BlockGeometry
+{
+    int blockFrames      { 8192 };    // frames per read / resample / encode block
+    int writeBufferBytes { 16384 };   // FileOutputStream buffer for each FLAC output
+};
+
+// Per-machine geometry profile. `wav2flac --calibrate [dir]` benchmarks a range
+// of geometries on synthetic audio and stores the fastest for each channel-count /
+// bit-depth class; conversions then pick it up automatically, and running
+// processes reload it when the file changes. Without a profile (or when it was
+// written on a different CPU) the defaults above apply.
+//
+// There is one profile per machine, not per volume: the write buffer is tuned
+// for the volume --calibrate ran on and applied to every output, so calibrate
+// on the volume most conversions write to.
+namespace BlockGeometryProfile
+{
+    // "stereo-16", "multi-24", "wide-24", ...
+    juce::String classFor (int numChannels, int bitsPerSample);
+
+    BlockGeometry lookup (int numChannels, int bitsPerSample);
+
+    // `--calibrate [dir]`: returns the directory to benchmark in, which should
+    // be on the volume conversions write to. Defaults to the home directory.
+    std::optional<juce::File> parseCalibrateCommandLine (const juce::StringArray& args);
+
+    // Runs the benchmark in a scratch folder under directory and saves the
+    // profile. log receives one line per step.
+    bool calibrate (const juce::File& directory, const std::function<void (const juce::String&)>& log);
+
+    juce::File getProfileFile();
+}
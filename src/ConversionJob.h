@@ -3,11 +3,56 @@
 
 enum class JobStatus { Queued, Converting, Done, Error };
 
+// Where an archive entry's bytes sit, recorded when the archive is listed so
+// that opening the entry later needs no walk over the archive's headers.
+struct ArchiveLocation
+{
+    juce::int64 offset     { -1 };      // tar: first data byte; zip: local file header; -1 = look up by name
+    juce::int64 storedSize { 0 };       // bytes the entry occupies in the archive
+    juce::int64 size       { 0 };       // bytes once extracted
+    bool        compressed { false };   // deflated: seeking means decompressing up to the target
+};
+
 struct ConversionJob
 {
     juce::File   inputFile;
     juce::String errorMessage;
     JobStatus    status { JobStatus::Queued };
+    juce::String archiveEntry;    // non-empty: path of the WAV inside inputFile (.zip/.tar)
+    ArchiveLocation archiveLocation;
+
+    juce::String getDisplayName() const
+    {
+        return archiveEntry.isEmpty() ? inputFile.getFileName()
+                                      : inputFile.getFileName() + " / " + archiveEntry;
+    }
+
+    // Loose files convert next to the source. Archive entries go into a folder
+    // named after the archive, keeping their relative path; ".." and absolute
+    // components are dropped so an entry can never escape that folder.
+    // `suffix` is appended to the file name, e.g. "_24-48" for one of several outputs.
+    juce::File getOutputFile (const juce::String& suffix = {}) const
+    {
+        auto withSuffix = [&suffix] (const juce::File& f)
+        {
+            return f.getSiblingFile (f.getFileNameWithoutExtension() + suffix + ".flac");
+        };
+
+        if (archiveEntry.isEmpty())
+            return withSuffix (inputFile);
+
+        auto parts = juce::StringArray::fromTokens (archiveEntry, "/\\", {});
+        parts.removeEmptyStrings();
+        parts.removeString (".");
+        parts.removeString ("..");
+
+        for (auto& p : parts)
+            p = juce::File::createLegalFileName (p);
+
+        auto dir = inputFile.getParentDirectory()
+                            .getChildFile (inputFile.getFileNameWithoutExtension());
+        return withSuffix (dir.getChildFile (parts.joinIntoString ("/")));
+    }
 };
 
 struct ConversionSettings
@@ -15,4 +60,20 @@ struct ConversionSettings
     int targetSampleRate { 0 };   // 0 = keep original
     int targetBitDepth   { 0 };   // 0 = keep original; valid: 16, 24
     int flacQuality      { 5 };   // 0–8 compression level index
+    juce::String outputSuffix;    // appended to the output file name; needed when a job has several profiles
+
+    // FLAC max is 24-bit; 32-bit int and float sources are clamped to 24
+    int outputBitDepth (int sourceBits) const
+    {
+        return juce::jmin (targetBitDepth > 0 ? targetBitDepth : sourceBits, 24);
+    }
+};
+
+// Background mode for hosts shared with latency-sensitive services.
+struct ResourceLimits
+{
+    int         cpuPercent       { 100 };  // share of wall time the pipeline may be busy, 1–100
+    juce::int64 ioBytesPerSecond { 0 };    // read + write cap; 0 = unlimited
+
+    bool isBackground() const { return cpuPercent < 100 || ioBytesPerSecond > 0; }
 };
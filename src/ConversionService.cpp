@@ -0,0 +1,506 @@
+#include "ConversionService.h"
+#include "ResourceGovernor.h"
+#include <algorithm>
+
+#if !JUCE_WINDOWS
+ #include <cerrno>
+ #include <cstring>
+ #include <fcntl.h>
+ #include <poll.h>
+ #include <sys/socket.h>
+ #include <sys/stat.h>
+ #include <sys/un.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr juce::uint32 kMaxFrameBytes  = 1 << 20;
+    constexpr size_t       kMaxOutboxBytes = 4 << 20;   // replies waiting for a client that isn't reading
+
+   #if JUCE_LINUX || JUCE_BSD
+    constexpr int kSendFlags = MSG_NOSIGNAL;
+   #else
+    constexpr int kSendFlags = 0;   // SO_NOSIGPIPE is set on the socket instead
+   #endif
+
+    juce::DynamicObject::Ptr makeReply (const juce::var& id, const char* event)
+    {
+        juce::DynamicObject::Ptr o (new juce::DynamicObject());
+        o->setProperty ("id", id);
+        o->setProperty ("event", event);
+        return o;
+    }
+
+    ConversionSettings readProfile (const juce::var& v)
+    {
+        ConversionSettings s;
+        s.targetSampleRate = int (v.getProperty ("sampleRate", 0));
+        s.targetBitDepth   = int (v.getProperty ("bitDepth", 0));
+        s.flacQuality      = juce::jlimit (0, 8, int (v.getProperty ("level", 5)));
+        // Goes into the output file name; without separators it can't point elsewhere
+        s.outputSuffix     = juce::File::createLegalFileName (v.getProperty ("suffix", {}).toString());
+        return s;
+    }
+}
+
+// ─── Connection ──────────────────────────────────────────────────────────────
+// Shared between the I/O thread (reads) and the workers (replies). The socket
+// is non-blocking and closed only when the last job referring to it has finished.
+struct ConversionService::Connection
+{
+    explicit Connection (int socketFd) : fd (socketFd) {}
+
+    ~Connection()
+    {
+       #if !JUCE_WINDOWS
+        ::close (fd);
+       #endif
+    }
+
+    // Queues one framed message and writes as much as the socket takes right
+    // now; the I/O thread sends the rest once the socket is writable. Never
+    // blocks, so a client that stops reading can't stall a worker or the I/O
+    // thread. Callable from any thread.
+    void send (const juce::var& message)
+    {
+        if (!open)
+            return;
+
+        const auto   json = juce::JSON::toString (message, true);
+        const auto   len  = juce::uint32 (json.getNumBytesAsUTF8());
+        const juce::uint8 header[4] = { juce::uint8 (len >> 24), juce::uint8 (len >> 16),
+                                        juce::uint8 (len >> 8),  juce::uint8 (len) };
+
+        juce::ScopedLock sl (writeLock);
+        if (outbox.getSize() + 4 + len > kMaxOutboxBytes)
+        {
+            drop();
+            return;
+        }
+
+        outbox.append (header, 4);
+        outbox.append (json.toRawUTF8(), len);
+        flushLocked();
+    }
+
+    // I/O thread, when poll() reports the socket writable
+    void flush()
+    {
+        juce::ScopedLock sl (writeLock);
+        flushLocked();
+    }
+
+    bool hasPendingOutput() const
+    {
+        juce::ScopedLock sl (writeLock);
+        return !outbox.isEmpty();
+    }
+
+    const int             fd;
+    std::atomic<bool>     open       { true };
+    bool                  readClosed { false };   // I/O thread only: client half-closed
+    juce::MemoryBlock     inbox;                  // I/O thread only
+
+private:
+    void drop()
+    {
+        open = false;   // running jobs for this client see it and stop
+        outbox.reset();
+    }
+
+    void flushLocked()
+    {
+       #if !JUCE_WINDOWS
+        while (open && !outbox.isEmpty())
+        {
+            const auto sent = ::send (fd, outbox.getData(), outbox.getSize(), kSendFlags);
+            if (sent < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    drop();
+                return;
+            }
+            outbox.removeSection (0, size_t (sent));
+        }
+       #else
+        drop();
+       #endif
+    }
+
+    juce::CriticalSection writeLock;
+    juce::MemoryBlock     outbox;
+};
+
+struct ConversionService::Request
+{
+    std::shared_ptr<Connection>     conn;
+    juce::var                       id;
+    ConversionJob                   job;
+    juce::Array<ConversionSettings> profiles;
+    int                             priority      { 0 };
+    juce::uint64                    seq           { 0 };
+    juce::int64                     receivedTicks { 0 };
+};
+
+bool ConversionService::RequestOrder::operator() (const std::shared_ptr<Request>& a,
+                                                  const std::shared_ptr<Request>& b) const
+{
+    // priority_queue keeps the "largest" on top: higher priority, then oldest
+    if (a->priority != b->priority)
+        return a->priority < b->priority;
+    return a->seq > b->seq;
+}
+
+// ─── I/O thread ──────────────────────────────────────────────────────────────
+// Accepts clients and reads frames from all of them with a single poll loop.
+class ConversionService::IoThread : public juce::Thread
+{
+public:
+    explicit IoThread (ConversionService& s)
+        : juce::Thread ("Wav2FlacYeah Service I/O"), service (s) {}
+
+    void run() override
+    {
+       #if !JUCE_WINDOWS
+        std::vector<std::shared_ptr<Connection>> conns;
+        std::vector<pollfd> fds;
+
+        while (!threadShouldExit())
+        {
+            fds.clear();
+            fds.push_back ({ service.listenFd, POLLIN, 0 });
+            for (auto& c : conns)
+            {
+                short events = c->readClosed ? 0 : POLLIN;
+                if (c->hasPendingOutput())
+                    events |= POLLOUT;
+                fds.push_back ({ c->fd, events, 0 });
+            }
+
+            // Short timeout so stop() and freshly queued replies are noticed promptly
+            if (::poll (fds.data(), nfds_t (fds.size()), 100) <= 0)
+                continue;
+
+            for (size_t i = 1; i < fds.size(); ++i)
+            {
+                const auto ev = fds[i].revents;
+                if (ev == 0)
+                    continue;
+
+                auto& c = conns[i - 1];
+
+                // Only a fully closed or broken socket counts as a disconnect
+                if ((ev & (POLLHUP | POLLERR | POLLNVAL)) != 0)
+                {
+                    c->open = false;
+                    continue;
+                }
+
+                if ((ev & POLLOUT) != 0)
+                    c->flush();
+
+                if ((ev & POLLIN) != 0)
+                {
+                    char buf[65536];
+                    const auto n = ::recv (c->fd, buf, sizeof (buf), 0);
+
+                    if (n > 0)
+                    {
+                        c->inbox.append (buf, size_t (n));
+                        drainFrames (c);
+                    }
+                    else if (n == 0)
+                    {
+                        c->readClosed = true;   // half-close: the client still wants its replies
+                    }
+                    else if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)
+                    {
+                        c->open = false;
+                    }
+                }
+            }
+
+            // A half-closed client is done once its jobs have finished and
+            // their replies are out; only `conns` still holds it then
+            conns.erase (std::remove_if (conns.begin(), conns.end(), [] (const auto& c)
+                         {
+                             return !c->open || (c->readClosed && c.use_count() == 1 && !c->hasPendingOutput());
+                         }),
+                         conns.end());
+
+            if ((fds[0].revents & POLLIN) != 0)
+            {
+                const int fd = ::accept (service.listenFd, nullptr, nullptr);
+                if (fd >= 0)
+                {
+                    ::fcntl (fd, F_SETFL, ::fcntl (fd, F_GETFL, 0) | O_NONBLOCK);
+                   #ifdef SO_NOSIGPIPE
+                    int one = 1;
+                    ::setsockopt (fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof (one));
+                   #endif
+                    conns.push_back (std::make_shared<Connection> (fd));
+                }
+            }
+        }
+       #endif
+    }
+
+private:
+    void drainFrames (const std::shared_ptr<Connection>& c)
+    {
+        auto& in = c->inbox;
+
+        while (in.getSize() >= 4)
+        {
+            const auto* b   = static_cast<const juce::uint8*> (in.getData());
+            const auto  len = (juce::uint32 (b[0]) << 24) | (juce::uint32 (b[1]) << 16)
+                            | (juce::uint32 (b[2]) << 8)  |  juce::uint32 (b[3]);
+
+            if (len > kMaxFrameBytes)
+            {
+                // Can't find the next frame boundary: stop reading, but let the
+                // reply and any running jobs finish
+                auto reply = makeReply ({}, "error");
+                reply->setProperty ("message", "Frame too large");
+                c->send (juce::var (reply.get()));
+                c->readClosed = true;
+                in.reset();
+                return;
+            }
+
+            if (in.getSize() < size_t (len) + 4)
+                return;
+
+            const auto text = juce::String::fromUTF8 (reinterpret_cast<const char*> (b + 4), int (len));
+            in.removeSection (0, size_t (len) + 4);
+            service.enqueue (c, juce::JSON::parse (text));
+        }
+    }
+
+    ConversionService& service;
+};
+
+// ─── Worker ──────────────────────────────────────────────────────────────────
+// Long-lived; keeps its FileConverter (and so the registered formats) warm.
+class ConversionService::Worker : public juce::Thread
+{
+public:
+    Worker (ConversionService& s, int index)
+        : juce::Thread ("Wav2FlacYeah Service Worker " + juce::String (index)),
+          service (s),
+          converter (&s.branchPool) {}
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            auto req = service.waitForRequest (*this);
+            if (req == nullptr)
+                return;
+
+            process (*req);
+        }
+    }
+
+private:
+    void process (Request& r)
+    {
+        auto conn = r.conn;
+        if (!conn->open)
+            return; // client went away while the job was queued
+
+        ResourceGovernor governor ({});
+
+        const bool ok = converter.convert (r.job, r.profiles, governor,
+            [this, conn] { return threadShouldExit() || !conn->open; },
+            [&r, conn] (float fp)
+            {
+                auto reply = makeReply (r.id, "progress");
+                reply->setProperty ("progress", fp);
+                conn->send (juce::var (reply.get()));
+            });
+
+        auto reply = makeReply (r.id, ok ? "done" : "error");
+
+        if (ok)
+        {
+            juce::Array<juce::var> outputs;
+            for (const auto& p : r.profiles)
+                outputs.add (r.job.getOutputFile (p.outputSuffix).getFullPathName());
+
+            reply->setProperty ("outputs", outputs);
+            reply->setProperty ("ms", juce::Time::highResolutionTicksToSeconds (
+                                          juce::Time::getHighResolutionTicks() - r.receivedTicks) * 1000.0);
+        }
+        else
+        {
+            reply->setProperty ("message", r.job.errorMessage.isNotEmpty() ? r.job.errorMessage
+                                                                           : juce::String ("Cancelled"));
+        }
+
+        conn->send (juce::var (reply.get()));
+    }
+
+    ConversionService& service;
+    FileConverter      converter;
+};
+
+// ─── ConversionService ───────────────────────────────────────────────────────
+std::optional<ConversionService::Options> ConversionService::parseCommandLine (const juce::StringArray& args)
+{
+    const int serveIdx = args.indexOf ("--serve");
+    if (serveIdx < 0 || serveIdx + 1 >= args.size())
+        return std::nullopt;
+
+    Options o;
+    o.socketPath = juce::File::getCurrentWorkingDirectory().getChildFile (args[serveIdx + 1]);
+
+    const int workersIdx = args.indexOf ("--workers");
+    if (workersIdx >= 0 && workersIdx + 1 < args.size())
+        o.numWorkers = juce::jmax (0, args[workersIdx + 1].getIntValue());
+
+    return o;
+}
+
+ConversionService::ConversionService (Options o)
+    : options (std::move (o)),
+      branchPool (juce::ThreadPoolOptions{}.withThreadName ("Wav2FlacYeah Service Branch"))
+{
+}
+
+ConversionService::~ConversionService()
+{
+    stop();
+}
+
+bool ConversionService::start (juce::String& error)
+{
+   #if JUCE_WINDOWS
+    error = "The conversion service needs Unix domain sockets, which this build does not support";
+    return false;
+   #else
+    const auto path = options.socketPath.getFullPathName();
+
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    if (path.getNumBytesAsUTF8() >= sizeof (addr.sun_path))
+    {
+        error = "Socket path too long: " + path;
+        return false;
+    }
+    std::memcpy (addr.sun_path, path.toRawUTF8(), path.getNumBytesAsUTF8());
+
+    // A socket left behind by a previous run would make bind() fail; anything
+    // else at that path is not ours to delete
+    struct stat st;
+    if (::lstat (path.toRawUTF8(), &st) == 0)
+    {
+        if (!S_ISSOCK (st.st_mode))
+        {
+            error = path + " exists and is not a socket";
+            return false;
+        }
+        ::unlink (path.toRawUTF8());
+    }
+
+    listenFd = ::socket (AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0
+        || ::bind (listenFd, reinterpret_cast<const sockaddr*> (&addr), sizeof (addr)) != 0
+        || ::listen (listenFd, 64) != 0)
+    {
+        error = "Cannot listen on " + path + ": " + juce::String (std::strerror (errno));
+        if (listenFd >= 0)
+            ::close (listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    ioThread = std::make_unique<IoThread> (*this);
+    ioThread->startThread();
+
+    const int numWorkers = options.numWorkers > 0 ? options.numWorkers
+                                                  : juce::SystemStats::getNumCpus();
+    for (int i = 0; i < numWorkers; ++i)
+        workers.add (new Worker (*this, i + 1))->startThread();
+
+    return true;
+   #endif
+}
+
+void ConversionService::stop()
+{
+    {
+        std::lock_guard<std::mutex> lk (queueLock);
+        stopping = true;
+    }
+    queueChanged.notify_all();
+
+    if (ioThread != nullptr)
+        ioThread->stopThread (1000);
+    ioThread.reset();
+
+    for (auto* w : workers)
+        w->signalThreadShouldExit();
+    for (auto* w : workers)
+        w->stopThread (4000);
+    workers.clear();
+
+   #if !JUCE_WINDOWS
+    if (listenFd >= 0)
+    {
+        ::close (listenFd);
+        ::unlink (options.socketPath.getFullPathName().toRawUTF8());
+        listenFd = -1;
+    }
+   #endif
+}
+
+void ConversionService::enqueue (std::shared_ptr<Connection> conn, const juce::var& message)
+{
+    const auto input = message.getProperty ("input", {}).toString();
+
+    if (!message.isObject() || !juce::File::isAbsolutePath (input))
+    {
+        auto reply = makeReply (message.getProperty ("id", {}), "error");
+        reply->setProperty ("message", "Request needs an absolute \"input\" path");
+        conn->send (juce::var (reply.get()));
+        return;
+    }
+
+    auto req = std::make_shared<Request>();
+    req->conn              = std::move (conn);
+    req->id                = message.getProperty ("id", {});
+    req->job.inputFile     = juce::File (input);
+    req->job.archiveEntry  = message.getProperty ("entry", {}).toString();
+    req->priority          = int (message.getProperty ("priority", 0));
+    req->receivedTicks     = juce::Time::getHighResolutionTicks();
+
+    if (auto* list = message.getProperty ("profiles", {}).getArray())
+        for (const auto& p : *list)
+            req->profiles.add (readProfile (p));
+    else
+        req->profiles.add (readProfile (message));
+
+    {
+        std::lock_guard<std::mutex> lk (queueLock);
+        req->seq = nextSeq++;
+        pending.push (std::move (req));
+    }
+    queueChanged.notify_one();
+}
+
+std::shared_ptr<ConversionService::Request> ConversionService::waitForRequest (juce::Thread& worker)
+{
+    std::unique_lock<std::mutex> lk (queueLock);
+    queueChanged.wait (lk, [&] { return stopping || worker.threadShouldExit() || !pending.empty(); });
+
+    if (stopping || worker.threadShouldExit())
+        return nullptr;
+
+    auto req = pending.top();
+    pending.pop();
+    return req;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include "ConversionJob.h"
+#include "FileConverter.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <vector>
+
+// Resident conversion service on a local Unix domain socket:
+//
+//     wav2flac --serve /tmp/wav2flac.sock [--workers N]
+//
+// Warm worker threads (formats registered, branch pool running) take jobs
+// off a priority queue, so a request costs a queue hand-off rather than an
+// app launch.
+//
+// Framing: every message in either direction is a 4-byte big-endian length
+// followed by that many bytes of UTF-8 JSON.
+//
+// Request:  { "id": any, "input": "/path/a.wav", "entry": "dir/b.wav" (in an archive),
+//             "priority": 0 (higher runs first),
+//             "sampleRate": 0, "bitDepth": 0, "level": 5,
+//             "profiles": [ { "sampleRate", "bitDepth", "level", "suffix" }, ... ] }
+// Replies:  { "id", "event": "progress", "progress": 0.42 }
+//           { "id", "event": "done", "outputs": [ ... ], "ms": 12.3 }
+//           { "id", "event": "error", "message": "..." }
+//
+// A client that disconnects cancels its jobs that are still running. Half-
+// closing after the last request (shutdown(SHUT_WR), `nc -N`) is not a
+// disconnect: replies still arrive. A client that stops reading is dropped
+// once 4 MB of replies are waiting for it.
+// Not available on Windows.
+class ConversionService
+{
+public:
+    struct Options
+    {
+        juce::File socketPath;
+        int        numWorkers { 0 };   // 0 = one per CPU
+    };
+
+    static std::optional<Options> parseCommandLine (const juce::StringArray& args);
+
+    explicit ConversionService (Options options);
+    ~ConversionService();
+
+    // Binds the socket and starts the I/O and worker threads.
+    bool start (juce::String& error);
+    void stop();
+
+private:
+    struct Connection;
+    struct Request;
+    class  IoThread;
+    class  Worker;
+
+    struct RequestOrder
+    {
+        bool operator() (const std::shared_ptr<Request>& a, const std::shared_ptr<Request>& b) const;
+    };
+
+    void enqueue (std::shared_ptr<Connection> conn, const juce::var& message);
+    std::shared_ptr<Request> waitForRequest (juce::Thread& worker);
+
+    const Options options;
+    int           listenFd { -1 };
+
+    std::mutex                queueLock;
+    std::condition_variable   queueChanged;
+    bool                      stopping { false };
+    juce::uint64              nextSeq  { 0 };
+    std::priority_queue<std::shared_ptr<Request>,
+                        std::vector<std::shared_ptr<Request>>,
+                        RequestOrder> pending;
+
+    juce::ThreadPool                branchPool;
+    std::unique_ptr<IoThread>       ioThread;
+    juce::OwnedArray<Worker>        workers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ConversionService)
+};
@@ -3,6 +3,8 @@
 #include <juce_events/juce_events.h>
 #include <juce_core/juce_core.h>
 #include "ConversionJob.h"
+#include "FileConverter.h"
+#include "ResourceGovernor.h"
 #include <functional>
 
 class ConversionThread : public juce::Thread
@@ -14,25 +16,32 @@ public:
                                                   JobStatus status,
                                                   juce::String errorMessage)>;
 
+    using FinishedCallback = std::function<void (const ThroughputStats&)>;
+
     ConversionThread();
     ~ConversionThread() override;
 
     // Call before startThread(). Thread receives its own copy of the job list.
-    void setJobs (juce::Array<ConversionJob> jobs,
-                  ConversionSettings         settings,
-                  ProgressCallback           callback);
+    // Every file is read once and encoded to one output per profile.
+    // onFinished runs on the message thread after the last progress callback.
+    void setJobs (juce::Array<ConversionJob>      jobs,
+                  juce::Array<ConversionSettings> profiles,
+                  ResourceLimits                  limits,
+                  ProgressCallback                callback,
+                  FinishedCallback                onFinished = {});
 
     void run() override;
 
 private:
-    bool convertFile (ConversionJob& job, const ConversionSettings& s);
-
-    juce::Array<ConversionJob>  jobs;
-    ConversionSettings          settings;
-    ProgressCallback            progressCallback;
-    juce::CriticalSection       lock;
-
-    juce::AudioFormatManager    formatManager;
+    juce::Array<ConversionJob>      jobs;
+    juce::Array<ConversionSettings> profiles;
+    ResourceLimits                  limits;
+    ProgressCallback                progressCallback;
+    FinishedCallback                finishedCallback;
+    juce::CriticalSection           lock;
+
+    juce::ThreadPool                branchPool;    // runs the extra output branches
+    FileConverter                   converter;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ConversionThread)
 };
@@ -1,4 +1,5 @@
 #include "ConverterComponent.h"
+#include "ArchiveSource.h"
 #include <BinaryData.h>
 
 using namespace juce;
@@ -41,8 +42,33 @@ ConverterComponent::ConverterComponent()
     qualSlider.setSliderStyle (Slider::LinearHorizontal);
     qualSlider.setTextBoxStyle (Slider::TextBoxRight, false, 28, 20);
 
+    // Delivery set: one read per file, three outputs
+    deliveryToggle.setColour (ToggleButton::textColourId, kSubtext);
+    deliveryToggle.onClick = [this]
+    {
+        const bool single = !deliveryToggle.getToggleState();
+        srCombo.setEnabled (single);
+        bdCombo.setEnabled (single);
+        clearEstimate();
+    };
+
+    // Background limits: CPU duty cycle and I/O bandwidth caps
+    cpuCombo.addItem ("No CPU cap", 1);
+    cpuCombo.addItem ("75% CPU",    2);
+    cpuCombo.addItem ("50% CPU",    3);
+    cpuCombo.addItem ("25% CPU",    4);
+    cpuCombo.addItem ("10% CPU",    5);
+    cpuCombo.setSelectedId (1, dontSendNotification);
+
+    ioCombo.addItem ("No I/O cap", 1);
+    ioCombo.addItem ("200 MB/s",   2);
+    ioCombo.addItem ("100 MB/s",   3);
+    ioCombo.addItem ("50 MB/s",    4);
+    ioCombo.addItem ("20 MB/s",    5);
+    ioCombo.setSelectedId (1, dontSendNotification);
+
     // Label colours
-    for (auto* l : { &srLabel, &bdLabel, &qualLabel })
+    for (auto* l : { &srLabel, &bdLabel, &qualLabel, &limitLabel })
     {
         l->setFont (FontOptions (11.5f));
         l->setColour (Label::textColourId, kSubtext);
@@ -52,6 +78,10 @@ ConverterComponent::ConverterComponent()
     statusLabel.setColour (Label::textColourId, kSubtext);
     statusLabel.setJustificationType (Justification::centredLeft);
 
+    estimateLabel.setFont (FontOptions (11.0f));
+    estimateLabel.setColour (Label::textColourId, kSubtext);
+    estimateLabel.setJustificationType (Justification::topLeft);
+
     perFileLabel.setFont (FontOptions (10.0f));
     perFileLabel.setColour (Label::textColourId, kSubtext);
     overallLabel.setFont (FontOptions (10.0f));
@@ -61,7 +91,7 @@ ConverterComponent::ConverterComponent()
     browseBtn.onClick = [this]
     {
         fileChooser = std::make_unique<FileChooser> ("Select WAV files",
-            File::getSpecialLocation (File::userMusicDirectory), "*.wav;*.WAV");
+            File::getSpecialLocation (File::userMusicDirectory), "*.wav;*.WAV;*.zip;*.tar");
         fileChooser->launchAsync (
             FileBrowserComponent::openMode |
             FileBrowserComponent::canSelectFiles |
@@ -81,12 +111,21 @@ ConverterComponent::ConverterComponent()
         jobs.clear();
         perFileProg = overallProg = 0.0;
         statusLabel.setText ({}, dontSendNotification);
+        clearEstimate();
         fileList.updateContent();
         updateButtons();
     };
 
     convertBtn.onClick = [this] { startConversion(); };
     cancelBtn.onClick  = [this] { stopConversion(); };
+    estimateBtn.onClick = [this] { startEstimate(); };
+
+    // Any settings change invalidates a previous estimate
+    srCombo.onChange         = [this] { clearEstimate(); };
+    bdCombo.onChange         = [this] { clearEstimate(); };
+    qualSlider.onValueChange = [this] { clearEstimate(); };
+    cpuCombo.onChange        = [this] { clearEstimate(); };
+    ioCombo.onChange         = [this] { clearEstimate(); };
 
     // File list
     fileList.setModel (this);
@@ -95,16 +134,20 @@ ConverterComponent::ConverterComponent()
     fileList.setColour (ListBox::outlineColourId,    kBorder);
     fileList.setOutlineThickness (1);
 
-    for (auto* c : { &srLabel, &bdLabel, &qualLabel,
-                     &perFileLabel, &overallLabel, &statusLabel })
+    for (auto* c : { &srLabel, &bdLabel, &qualLabel, &limitLabel,
+                     &perFileLabel, &overallLabel, &statusLabel, &estimateLabel })
         addAndMakeVisible (c);
     addAndMakeVisible (srCombo);
     addAndMakeVisible (bdCombo);
     addAndMakeVisible (qualSlider);
+    addAndMakeVisible (deliveryToggle);
+    addAndMakeVisible (cpuCombo);
+    addAndMakeVisible (ioCombo);
     addAndMakeVisible (browseBtn);
     addAndMakeVisible (clearBtn);
     addAndMakeVisible (convertBtn);
     addAndMakeVisible (cancelBtn);
+    addAndMakeVisible (estimateBtn);
     addAndMakeVisible (fileList);
     addAndMakeVisible (perFileBar);
     addAndMakeVisible (overallBar);
@@ -115,6 +158,7 @@ ConverterComponent::ConverterComponent()
 
 ConverterComponent::~ConverterComponent()
 {
+    estimator.cancel();
     convThread.stopThread (4000);
 }
 
@@ -153,12 +197,31 @@ void ConverterComponent::resized()
     qualLabel.setBounds (row (18));
     panel.removeFromTop (2);
     qualSlider.setBounds (row (26));
+    panel.removeFromTop (10);
+
+    // Multi-target
+    deliveryToggle.setBounds (row (22));
+    panel.removeFromTop (10);
+
+    // Background limits
+    limitLabel.setBounds (row (18));
+    panel.removeFromTop (2);
+    auto limitRow = row (24);
+    cpuCombo.setBounds (limitRow.removeFromLeft ((limitRow.getWidth() - 6) / 2));
+    limitRow.removeFromLeft (6);
+    ioCombo.setBounds (limitRow);
     panel.removeFromTop (18);
 
     // Buttons
     convertBtn.setBounds (row (28));
     panel.removeFromTop (6);
     cancelBtn.setBounds (row (28));
+    panel.removeFromTop (18);
+
+    // Pre-flight estimate
+    estimateBtn.setBounds (row (28));
+    panel.removeFromTop (6);
+    estimateLabel.setBounds (row (64));
 
     // Left: file area
     auto left = full.reduced (10, 10);
@@ -245,7 +308,7 @@ void ConverterComponent::paint (Graphics& g)
 
         g.setFont (FontOptions (14.0f));
         g.setColour (kAccent);
-        g.drawText ("Drop WAV files here", zone, Justification::centred, false);
+        g.drawText ("Drop WAV files or archives here", zone, Justification::centred, false);
     }
 
     // ── Empty state hint ────────────────────────────────────────────────────
@@ -254,7 +317,7 @@ void ConverterComponent::paint (Graphics& g)
         auto zone = fileList.getBounds().toFloat();
         g.setFont (FontOptions (13.0f));
         g.setColour (kSubtext);
-        g.drawText ("Drag & drop WAV files here, or click \"Add Files...\"",
+        g.drawText ("Drag & drop WAV files or .zip/.tar bundles here, or click \"Add Files...\"",
                     zone, Justification::centred, false);
     }
 }
@@ -263,7 +326,7 @@ void ConverterComponent::paint (Graphics& g)
 bool ConverterComponent::isInterestedInFileDrag (const StringArray& files)
 {
     for (auto& f : files)
-        if (File (f).hasFileExtension ("wav"))
+        if (File (f).hasFileExtension ("wav") || ArchiveSource::isArchive (File (f)))
             return true;
     return false;
 }
@@ -319,7 +382,7 @@ void ConverterComponent::paintListBoxItem (int row, Graphics& g,
 
     g.setFont (FontOptions (12.0f));
     g.setColour (kText);
-    g.drawText (job.inputFile.getFileName(),
+    g.drawText (job.getDisplayName(),
                 22, 0, width - 130, height,
                 Justification::centredLeft, true);
 
@@ -334,17 +397,46 @@ void ConverterComponent::paintListBoxItem (int row, Graphics& g,
 // ─── Helpers ─────────────────────────────────────────────────────────────────
 void ConverterComponent::addFiles (const StringArray& paths)
 {
+    auto addJob = [this] (const File& f, const String& entry, const ArchiveLocation& location)
+    {
+        for (auto& j : jobs)
+            if (j.inputFile == f && j.archiveEntry == entry)
+                return;
+        jobs.add ({ f, {}, JobStatus::Queued, entry, location });
+    };
+
+    StringArray skipped;
+
     for (auto& p : paths)
     {
         File f (p);
-        if (!f.hasFileExtension ("wav") || !f.existsAsFile())
+        if (!f.existsAsFile())
             continue;
-        bool dup = false;
-        for (auto& j : jobs)
-            if (j.inputFile == f) { dup = true; break; }
-        if (!dup)
-            jobs.add ({ f, {}, JobStatus::Queued });
+
+        if (ArchiveSource::isArchive (f))
+        {
+            // Queue the WAVs inside; they are streamed from the archive at convert time
+            String error;
+            const auto entries = ArchiveSource::listWavEntries (f, error);
+
+            if (error.isEmpty() && entries.isEmpty())
+                error = "no WAV files inside";
+            if (error.isNotEmpty())
+                skipped.add (f.getFileName() + ": " + error);
+
+            for (auto& entry : entries)
+                addJob (f, entry.name, entry.location);
+        }
+        else if (f.hasFileExtension ("wav"))
+        {
+            addJob (f, {}, {});
+        }
     }
+
+    if (!skipped.isEmpty())
+        statusLabel.setText ("Skipped " + skipped.joinIntoString ("; "), dontSendNotification);
+
+    clearEstimate();
     fileList.updateContent();
     updateButtons();
     repaint();
@@ -366,6 +458,44 @@ ConversionSettings ConverterComponent::buildSettings() const
     return s;
 }
 
+Array<ConversionSettings> ConverterComponent::buildProfiles() const
+{
+    const auto base = buildSettings();
+    if (!deliveryToggle.getToggleState())
+        return { base };
+
+    // Archive, broadcast and distribution masters from a single read
+    struct Target { int rate, bits; const char* suffix; };
+    static const Target targets[] = { { 96000, 24, "_24-96"   },
+                                      { 48000, 24, "_24-48"   },
+                                      { 44100, 16, "_16-44.1" } };
+
+    Array<ConversionSettings> profiles;
+    for (const auto& t : targets)
+    {
+        auto s = base;
+        s.targetSampleRate = t.rate;
+        s.targetBitDepth   = t.bits;
+        s.outputSuffix     = t.suffix;
+        profiles.add (s);
+    }
+    return profiles;
+}
+
+ResourceLimits ConverterComponent::buildLimits() const
+{
+    ResourceLimits l;
+
+    static const int cpuVals[] = { 100, 75, 50, 25, 10 };
+    int cid = cpuCombo.getSelectedId();
+    l.cpuPercent = (cid >= 1 && cid <= 5) ? cpuVals[cid - 1] : 100;
+
+    static const int ioMBps[] = { 0, 200, 100, 50, 20 };
+    int iid = ioCombo.getSelectedId();
+    l.ioBytesPerSecond = int64 ((iid >= 1 && iid <= 5) ? ioMBps[iid - 1] : 0) * 1000 * 1000;
+    return l;
+}
+
 void ConverterComponent::startConversion()
 {
     if (jobs.isEmpty() || convThread.isThreadRunning())
@@ -379,13 +509,55 @@ void ConverterComponent::startConversion()
     statusLabel.setText ("Starting...", dontSendNotification);
     fileList.updateContent();
 
-    convThread.setJobs (jobs, buildSettings(),
+    const auto limits = buildLimits();
+
+    convThread.setJobs (jobs, buildProfiles(), limits,
         [this] (int idx, float fp, float op, JobStatus st, String err)
         {
             onProgress (idx, fp, op, st, err);
+        },
+        [safeThis = SafePointer<ConverterComponent> (this)] (const ThroughputStats& st)
+        {
+            if (safeThis != nullptr)
+                safeThis->onFinished (st);
         });
 
-    convThread.startThread (Thread::Priority::normal);
+    convThread.startThread (limits.isBackground() ? Thread::Priority::background
+                                                  : Thread::Priority::normal);
+    updateButtons();
+}
+
+void ConverterComponent::startEstimate()
+{
+    if (jobs.isEmpty())
+        return;
+
+    estimateLabel.setText ("Estimating...", dontSendNotification);
+    estimateBtn.setEnabled (false);
+
+    estimator.start (jobs, buildProfiles(), buildLimits(),
+        [safeThis = SafePointer<ConverterComponent> (this)] (const BatchEstimate& e)
+        {
+            if (safeThis == nullptr)
+                return;
+
+            String text;
+            text << "Output: ~" << File::descriptionOfSizeInBytes (e.outputBytes)
+                 << " (from " << File::descriptionOfSizeInBytes (e.inputBytes) << ")\n"
+                 << "Encode time: ~" << RelativeTime (e.encodeSeconds).getDescription() << "\n"
+                 << "Sampled " << File::descriptionOfSizeInBytes (e.bytesSampled) << " of input";
+            if (e.numFailed > 0)
+                text << "\n" << e.numFailed << " file(s) unreadable";
+
+            safeThis->estimateLabel.setText (text, dontSendNotification);
+            safeThis->updateButtons();
+        });
+}
+
+void ConverterComponent::clearEstimate()
+{
+    estimator.cancel();
+    estimateLabel.setText ({}, dontSendNotification);
     updateButtons();
 }
 
@@ -419,7 +591,7 @@ void ConverterComponent::onProgress (int jobIdx, float fp, float op,
     {
         String msg;
         if (status == JobStatus::Converting)
-            msg = "Converting: " + jobs[jobIdx].inputFile.getFileName();
+            msg = "Converting: " + jobs[jobIdx].getDisplayName();
         else if (status == JobStatus::Done && jobIdx == jobs.size() - 1)
             msg = "All done! " + String (jobs.size()) + " file(s) converted.";
         else if (status == JobStatus::Error)
@@ -431,6 +603,21 @@ void ConverterComponent::onProgress (int jobIdx, float fp, float op,
         updateButtons();
 }
 
+void ConverterComponent::onFinished (const ThroughputStats& st)
+{
+    // Report what the run achieved, which matters most when it was capped
+    String msg = statusLabel.getText();
+    if (msg.isNotEmpty())
+        msg << "  |  ";
+
+    msg << String (st.bytesPerSecond() / 1.0e6, 1) << " MB/s, "
+        << String (st.realtimeFactor(), 1) << "x realtime, "
+        << String (st.busyPercent(), 0) << "% busy";
+
+    statusLabel.setText (msg, dontSendNotification);
+    updateButtons();
+}
+
 void ConverterComponent::updateButtons()
 {
     const bool running = convThread.isThreadRunning();
@@ -439,5 +626,8 @@ void ConverterComponent::updateButtons()
     browseBtn.setEnabled (!running);
     clearBtn.setEnabled  (!running && hasJobs);
     convertBtn.setEnabled (!running && hasJobs);
+    cpuCombo.setEnabled   (!running);
+    ioCombo.setEnabled    (!running);
     cancelBtn.setEnabled  (running);
+    estimateBtn.setEnabled (hasJobs);
 }
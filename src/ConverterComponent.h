@@ -3,6 +3,7 @@
 #include <juce_audio_formats/juce_audio_formats.h>
 #include "ConversionJob.h"
 #include "ConversionThread.h"
+#include "SizeEstimator.h"
 
 class ConverterComponent : public juce::Component,
                            public juce::FileDragAndDropTarget,
@@ -35,12 +36,20 @@ private:
     juce::ComboBox bdCombo;
     juce::Label    qualLabel  { {}, "Compression Level (0-8)" };
     juce::Slider   qualSlider;
+    juce::ToggleButton deliveryToggle { "Delivery set (24/96, 24/48, 16/44.1)" };
+    juce::Label    limitLabel { {}, "Background limit (CPU / I/O)" };
+    juce::ComboBox cpuCombo;
+    juce::ComboBox ioCombo;
 
     // Action buttons
     juce::TextButton browseBtn   { "Add Files..." };
     juce::TextButton clearBtn    { "Clear" };
     juce::TextButton convertBtn  { "Convert All" };
     juce::TextButton cancelBtn   { "Cancel" };
+    juce::TextButton estimateBtn { "Estimate Size" };
+
+    // Pre-flight estimate result
+    juce::Label    estimateLabel;
 
     // File queue
     juce::ListBox  fileList;
@@ -60,6 +69,7 @@ private:
     int                        currentJobIdx { -1 };
 
     ConversionThread convThread;
+    SizeEstimator    estimator;
 
     std::unique_ptr<juce::FileChooser> fileChooser;
 
@@ -67,9 +77,14 @@ private:
     void addFiles           (const juce::StringArray& paths);
     void startConversion    ();
     void stopConversion     ();
+    void startEstimate      ();
+    void clearEstimate      ();
     ConversionSettings buildSettings () const;
+    juce::Array<ConversionSettings> buildProfiles () const;
+    ResourceLimits     buildLimits   () const;
     void onProgress         (int jobIdx, float fileProg, float totalProg,
                              JobStatus status, const juce::String& errMsg);
+    void onFinished         (const ThroughputStats& stats);
     void updateButtons      ();
 
     juce::Image logo;
@@ -0,0 +1,327 @@
+#include "FileConverter.h"
+#include "ArchiveSource.h"
+#include "TraceRecorder.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cstring>
+
+namespace
+{
+    // AudioSource over a queue of pushed blocks, so a ResamplingAudioSource can
+    // be driven block by block from the reader loop. Reads silence when empty.
+    class BlockFifoSource : public juce::AudioSource
+    {
+    public:
+        BlockFifoSource (int numChannels, int initialCapacity)
+            : fifo (numChannels, initialCapacity) {}
+
+        void prepareToPlay (int, double) override {}
+        void releaseResources() override {}
+
+        void push (const juce::AudioBuffer<float>& src, int n)
+        {
+            // Move the unread tail to the front, then append
+            if (readPos > 0 && numReady > 0)
+                for (int ch = 0; ch < fifo.getNumChannels(); ++ch)
+                    std::memmove (fifo.getWritePointer (ch), fifo.getReadPointer (ch, readPos),
+                                  size_t (numReady) * sizeof (float));
+            readPos = 0;
+
+            if (numReady + n > fifo.getNumSamples())
+                fifo.setSize (fifo.getNumChannels(), numReady + n, true, false, true);
+
+            for (int ch = 0; ch < fifo.getNumChannels(); ++ch)
+                fifo.copyFrom (ch, numReady, src, ch, 0, n);
+            numReady += n;
+        }
+
+        void getNextAudioBlock (const juce::AudioSourceChannelInfo& info) override
+        {
+            const int n = juce::jmin (numReady, info.numSamples);
+
+            for (int ch = 0; ch < fifo.getNumChannels(); ++ch)
+                if (n > 0)
+                    info.buffer->copyFrom (ch, info.startSample, fifo, ch, readPos, n);
+
+            if (n < info.numSamples)
+                info.buffer->clear (info.startSample + n, info.numSamples - n);
+
+            readPos  += n;
+            numReady -= n;
+        }
+
+    private:
+        juce::AudioBuffer<float> fifo;
+        int readPos  { 0 };
+        int numReady { 0 };
+    };
+}
+
+// One output profile of a job: optional resampler plus its own FLAC writer.
+struct FileConverter::OutputBranch
+{
+    juce::File   outFile;
+    double       outRate { 0.0 };
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    juce::String error;
+
+    void prepare (double sourceRate, int64_t sourceFrames, int numCh, int blockSize)
+    {
+        srcRate = sourceRate;
+        if (outRate == srcRate)
+            return;
+
+        outFrames = int64_t (double (sourceFrames) * outRate / srcRate + 0.5);
+        fifo      = std::make_unique<BlockFifoSource> (numCh, blockSize * 2);
+        resampler = std::make_unique<juce::ResamplingAudioSource> (fifo.get(), false, numCh);
+        resampler->setResamplingRatio (srcRate / outRate);
+        resampler->prepareToPlay (blockSize, outRate);
+        block.setSize (numCh, blockSize);
+    }
+
+    // Consumes one decoded source block; srcPos is the source position after it.
+    void process (const juce::AudioBuffer<float>& src, int n, int64_t srcPos, bool atEnd)
+    {
+        if (resampler == nullptr)
+        {
+            W2F_TRACE_SPAN ("encode");
+            if (!writer->writeFromAudioSampleBuffer (src, 0, n))
+                error = "Write error";
+            return;
+        }
+
+        fifo->push (src, n);
+
+        // Trail the pushed input a little so the resampler's look-ahead never
+        // runs dry mid-stream; the last block drains the remainder.
+        const int64_t target = atEnd ? outFrames
+                                     : juce::jmin (outFrames, int64_t (double (srcPos - kResampleLag) * outRate / srcRate));
+
+        while (written < target)
+        {
+            const int m = int (juce::jmin (int64_t (block.getNumSamples()), target - written));
+            {
+                W2F_TRACE_SPAN ("resample");
+                juce::AudioSourceChannelInfo info (&block, 0, m);
+                resampler->getNextAudioBlock (info);
+            }
+
+            {
+                W2F_TRACE_SPAN ("encode");
+                if (!writer->writeFromAudioSampleBuffer (block, 0, m))
+                {
+                    error = "Write error during resample";
+                    return;
+                }
+            }
+            written += m;
+        }
+    }
+
+    void finish()
+    {
+        if (resampler != nullptr)
+            resampler->releaseResources();
+        writer.reset();
+    }
+
+private:
+    static constexpr int kResampleLag = 32;    // source frames
+
+    double  srcRate   { 0.0 };
+    int64_t outFrames { 0 };
+    int64_t written   { 0 };
+    std::unique_ptr<BlockFifoSource>             fifo;
+    std::unique_ptr<juce::ResamplingAudioSource> resampler;
+    juce::AudioBuffer<float>                     block;
+};
+
+FileConverter::FileConverter (juce::ThreadPool* pool)
+    : branchPool (pool)
+{
+    formatManager.registerBasicFormats();
+}
+
+FileConverter::~FileConverter() = default;
+
+void FileConverter::forEachBranch (juce::OwnedArray<OutputBranch>& branches,
+                                   const ResourceLimits& limits,
+                                   const std::function<void (OutputBranch&)>& fn)
+{
+    if (branches.isEmpty())
+        return;
+
+    // In background mode only this thread is throttled and moved to the idle
+    // CPU and I/O classes, so the branches take turns here instead of
+    // spreading over the pool at normal priority
+    if (branchPool == nullptr || limits.isBackground())
+    {
+        for (auto* b : branches)
+            fn (*b);
+        return;
+    }
+
+    // This thread takes the first branch, the pool runs the rest alongside it
+    juce::WaitableEvent done;
+    std::atomic<int>    remaining { branches.size() - 1 };
+
+    for (int b = 1; b < branches.size(); ++b)
+    {
+        branchPool->addJob ([&, b]
+        {
+            fn (*branches[b]);
+            if (--remaining == 0)
+                done.signal();
+        });
+    }
+
+    fn (*branches[0]);
+
+    if (branches.size() > 1)
+        done.wait();
+}
+
+bool FileConverter::convert (ConversionJob& job,
+                             const juce::Array<ConversionSettings>& outputProfiles,
+                             ResourceGovernor& governor,
+                             const std::function<bool()>& shouldExit,
+                             const ProgressFn& onProgress)
+{
+    W2F_TRACE_SPAN ("convert file");
+
+    if (outputProfiles.isEmpty())
+    {
+        job.errorMessage = "No output profile";
+        return false;
+    }
+
+    // Open reader
+    std::unique_ptr<juce::InputStream> inStream;
+    {
+        W2F_TRACE_SPAN ("open");
+        inStream = ArchiveSource::openInput (job);
+    }
+
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    if (inStream != nullptr)
+    {
+        W2F_TRACE_SPAN ("parse header");
+        reader = ArchiveSource::createReader (formatManager, std::move (inStream));
+    }
+
+    if (reader == nullptr)
+    {
+        job.errorMessage = "Cannot read: " + job.getDisplayName();
+        return false;
+    }
+
+    const double  srcRate   = reader->sampleRate;
+    const int     srcBits   = int (reader->bitsPerSample);
+    const int     numCh     = int (reader->numChannels);
+    const int64_t numFrames = reader->lengthInSamples;
+    const auto    geometry  = geometryOverride ? *geometryOverride
+                                               : BlockGeometryProfile::lookup (numCh, srcBits);
+    const int     blockSize = geometry.blockFrames;
+
+    // One branch per output profile, all fed from the same decoded blocks
+    juce::OwnedArray<OutputBranch> branches;
+
+    for (const auto& s : outputProfiles)
+    {
+        auto* b = branches.add (new OutputBranch());
+        b->outFile = job.getOutputFile (s.outputSuffix);
+
+        for (int k = 0; k < branches.size() - 1; ++k)
+        {
+            if (branches[k]->outFile == b->outFile)
+            {
+                job.errorMessage = "Two output profiles write " + b->outFile.getFileName();
+                return false;
+            }
+        }
+
+        b->outRate = (s.targetSampleRate > 0) ? double (s.targetSampleRate) : srcRate;
+        const int outBits = s.outputBitDepth (srcBits);
+
+        b->outFile.getParentDirectory().createDirectory();
+
+        std::unique_ptr<juce::OutputStream> outStream;
+        {
+            W2F_TRACE_SPAN ("open");
+            auto fileStream = std::make_unique<juce::FileOutputStream> (b->outFile, size_t (geometry.writeBufferBytes));
+            if (fileStream->failedToOpen())
+            {
+                job.errorMessage = "Cannot write: " + b->outFile.getFullPathName();
+                return false;
+            }
+            fileStream->setPosition (0);
+            fileStream->truncate();
+            outStream = std::move (fileStream);
+        }
+
+        outStream = std::make_unique<ResourceGovernor::CountingStream> (std::move (outStream), governor);
+
+        if (TraceRecorder::isEnabled())
+            outStream = std::make_unique<TraceRecorder::TracingOutputStream> (std::move (outStream));
+
+        juce::FlacAudioFormat flac;
+        b->writer.reset (flac.createWriterFor (outStream.get(),
+                                               b->outRate,
+                                               unsigned (numCh),
+                                               outBits,
+                                               {},
+                                               s.flacQuality));
+
+        if (b->writer == nullptr)
+        {
+            job.errorMessage = "FLAC writer failed (bit depth " + juce::String (outBits) + " unsupported?)";
+            return false;
+        }
+        outStream.release(); // writer now owns the stream
+
+        b->prepare (srcRate, numFrames, numCh, blockSize);
+    }
+
+    juce::AudioBuffer<float> buf (numCh, blockSize);
+    int64_t pos = 0;
+
+    while (pos < numFrames && !shouldExit())
+    {
+        int n = int (juce::jmin (int64_t (blockSize), numFrames - pos));
+        {
+            W2F_TRACE_SPAN ("read");
+            reader->read (&buf, 0, n, pos, true, true);
+        }
+        pos += n;
+
+        const bool atEnd = (pos == numFrames);
+        forEachBranch (branches, governor.getLimits(), [&] (OutputBranch& b) { b.process (buf, n, pos, atEnd); });
+
+        for (auto* b : branches)
+        {
+            if (b->error.isNotEmpty())
+            {
+                job.errorMessage = b->error;
+                return false;
+            }
+        }
+
+        {
+            W2F_TRACE_SPAN ("throttle");
+            governor.blockDone (juce::int64 (n) * numCh * (srcBits / 8), double (n) / srcRate);
+        }
+
+        const float fp = float (pos) / float (numFrames);
+        // Throttle: report every ~0.5% to avoid flooding the receiver
+        if (onProgress && int (fp * 200) != int ((fp - float (n) / float (numFrames)) * 200))
+            onProgress (fp);
+    }
+
+    // Destroying a writer flushes its last frames and rewrites STREAMINFO
+    forEachBranch (branches, governor.getLimits(), [] (OutputBranch& b)
+    {
+        W2F_TRACE_SPAN ("finalize");
+        b.finish();
+    });
+
+    return !shouldExit();
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_core/juce_core.h>
+#include "BlockGeometry.h"
+#include "ConversionJob.h"
+#include "ResourceGovernor.h"
+#include <functional>
+#include <optional>
+
+// Converts one source file to one FLAC per output profile. The source is read
+// and decoded once; every block fans out to a branch per profile. Holds the
+// registered formats, so a long-lived instance pays that setup only once.
+class FileConverter
+{
+public:
+    using ProgressFn = std::function<void (float fileProgress)>;
+
+    // Extra output branches run on branchPool when given, else on the caller.
+    explicit FileConverter (juce::ThreadPool* branchPool = nullptr);
+    ~FileConverter();
+
+    // shouldExit is polled between blocks. onProgress is called on the calling
+    // thread in ~0.5% steps. On failure job.errorMessage says why.
+    bool convert (ConversionJob&                         job,
+                  const juce::Array<ConversionSettings>& profiles,
+                  ResourceGovernor&                      governor,
+                  const std::function<bool()>&           shouldExit,
+                  const ProgressFn&                      onProgress);
+
+    // Pins the block geometry instead of taking it from the machine profile.
+    void setGeometryOverride (std::optional<BlockGeometry> geometry)  { geometryOverride = geometry; }
+
+private:
+    struct OutputBranch;
+
+    void forEachBranch (juce::OwnedArray<OutputBranch>& branches,
+                        const ResourceLimits& limits,
+                        const std::function<void (OutputBranch&)>& fn);
+
+    juce::AudioFormatManager formatManager;
+    juce::ThreadPool*        branchPool;
+    std::optional<BlockGeometry> geometryOverride;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FileConverter)
+};
@@ -1,20 +1,62 @@
 #include "MainWindow.h"
+#include "BlockGeometry.h"
+#include "ConversionService.h"
+#include "StreamingConverter.h"
+#include <cstdio>
 
 class Wav2FlacYeahApp final : public juce::JUCEApplication
 {
 public:
     const juce::String getApplicationName()    override { return JUCE_APPLICATION_NAME_STRING; }
     const juce::String getApplicationVersion() override { return JUCE_APPLICATION_VERSION_STRING; }
-    bool moreThanOneInstanceAllowed()          override { return false; }
+    // Pipeline, service and calibration invocations run side by side; only the GUI is single-instance
+    bool moreThanOneInstanceAllowed()          override { return streamingOptions().has_value()
+                                                               || serviceOptions().has_value()
+                                                               || calibrateDirectory().has_value(); }
 
     void initialise (const juce::String&) override
     {
+        if (auto options = streamingOptions())
+        {
+            setApplicationReturnValue (StreamingConverter::run (*options));
+            quit();
+            return;
+        }
+
+        if (auto directory = calibrateDirectory())
+        {
+            const bool ok = BlockGeometryProfile::calibrate (*directory, [] (const juce::String& line)
+            {
+                std::printf ("%s\n", line.toRawUTF8());
+                std::fflush (stdout);
+            });
+            setApplicationReturnValue (ok ? 0 : 1);
+            quit();
+            return;
+        }
+
+        // Headless: stays up until asked to quit
+        if (auto options = serviceOptions())
+        {
+            service = std::make_unique<ConversionService> (*options);
+
+            juce::String error;
+            if (!service->start (error))
+            {
+                std::fprintf (stderr, "wav2flac: %s\n", error.toRawUTF8());
+                setApplicationReturnValue (1);
+                quit();
+            }
+            return;
+        }
+
         mainWindow.reset (new MainWindow (getApplicationName()));
     }
 
     void shutdown() override
     {
         mainWindow = nullptr;
+        service    = nullptr;
     }
 
     void systemRequestedQuit() override
@@ -25,7 +67,23 @@ public:
     void anotherInstanceStarted (const juce::String&) override {}
 
 private:
-    std::unique_ptr<MainWindow> mainWindow;
+    static std::optional<StreamingConverter::Options> streamingOptions()
+    {
+        return StreamingConverter::parseCommandLine (getCommandLineParameterArray());
+    }
+
+    static std::optional<ConversionService::Options> serviceOptions()
+    {
+        return ConversionService::parseCommandLine (getCommandLineParameterArray());
+    }
+
+    static std::optional<juce::File> calibrateDirectory()
+    {
+        return BlockGeometryProfile::parseCalibrateCommandLine (getCommandLineParameterArray());
+    }
+
+    std::unique_ptr<MainWindow>        mainWindow;
+    std::unique_ptr<ConversionService> service;
 };
 
 START_JUCE_APPLICATION (Wav2FlacYeahApp)
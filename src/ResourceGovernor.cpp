@@ -0,0 +1,101 @@
+#include "ResourceGovernor.h"
+
+#if JUCE_LINUX
+ #include <sys/resource.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#elif JUCE_MAC
+ #include <sys/resource.h>
+#endif
+
+ResourceGovernor::ResourceGovernor (ResourceLimits l)
+    : limits (l),
+      startTicks (juce::Time::getHighResolutionTicks()),
+      lastTicks (startTicks)
+{
+}
+
+void ResourceGovernor::applyBackgroundScheduling()
+{
+   #if JUCE_LINUX
+    // Both calls act on the calling thread only when given its tid
+    const auto tid = pid_t (syscall (SYS_gettid));
+    setpriority (PRIO_PROCESS, id_t (tid), 19);
+
+    constexpr int ioprioWhoProcess = 1, ioprioClassIdle = 3, ioprioClassShift = 13;
+    syscall (SYS_ioprio_set, ioprioWhoProcess, tid, ioprioClassIdle << ioprioClassShift);
+   #elif JUCE_MAC
+    setiopolicy_np (IOPOL_TYPE_DISK, IOPOL_SCOPE_THREAD, IOPOL_THROTTLE);
+   #endif
+    // Elsewhere Thread::Priority::background is all we have
+}
+
+double ResourceGovernor::secondsSince (juce::int64 ticks) const
+{
+    return double (juce::Time::getHighResolutionTicks() - ticks)
+         / double (juce::Time::getHighResolutionTicksPerSecond());
+}
+
+void ResourceGovernor::blockDone (juce::int64 blockBytesRead, double blockAudioSeconds)
+{
+    bytesRead    += blockBytesRead;
+    audioSeconds += blockAudioSeconds;
+
+    if (!limits.isBackground())
+        return;
+
+    const double tps   = double (juce::Time::getHighResolutionTicksPerSecond());
+    const double share = double (juce::jlimit (1, 100, limits.cpuPercent)) / 100.0;
+    const double rate  = double (limits.ioBytesPerSecond);
+    const auto   moved = bytesRead + bytesWritten.load (std::memory_order_relaxed);
+
+    // Everything since the last call was busy time: it earns credit at the
+    // allowed rate and spends it at full rate. Credit is capped, so a slow
+    // stretch can't be saved up and spent later as a long burst.
+    const double busy = secondsSince (lastTicks);
+    cpuCredit = juce::jmin (kBurstSeconds * share, cpuCredit + busy * share) - busy;
+    ioCredit  = juce::jmin (kBurstSeconds * rate,  ioCredit  + busy * rate)  - double (moved - lastMoved);
+    lastMoved = moved;
+
+    double sleepSecs = 0.0;
+
+    if (limits.cpuPercent < 100 && cpuCredit < 0.0)
+        sleepSecs = -cpuCredit / share;
+
+    if (limits.ioBytesPerSecond > 0 && ioCredit < 0.0)
+        sleepSecs = juce::jmax (sleepSecs, -ioCredit / rate);
+
+    if (sleepSecs >= 0.001)
+    {
+        // Sleep in short slices so a cancel doesn't wait out a long throttle
+        const auto sleepStart = juce::Time::getHighResolutionTicks();
+        const auto until      = sleepStart + juce::int64 (sleepSecs * tps);
+
+        for (auto now = sleepStart; now < until && !juce::Thread::currentThreadShouldExit();
+             now = juce::Time::getHighResolutionTicks())
+        {
+            juce::Thread::sleep (juce::jlimit (1, 20, int ((until - now) * 1000 / juce::int64 (tps))));
+        }
+
+        const auto slept = juce::Time::getHighResolutionTicks() - sleepStart;
+        sleptTicks += slept;
+
+        // Idle time only earns credit
+        cpuCredit = juce::jmin (kBurstSeconds * share, cpuCredit + double (slept) / tps * share);
+        ioCredit  = juce::jmin (kBurstSeconds * rate,  ioCredit  + double (slept) / tps * rate);
+    }
+
+    lastTicks = juce::Time::getHighResolutionTicks();
+}
+
+ThroughputStats ResourceGovernor::getStats() const
+{
+    ThroughputStats st;
+    st.wallSeconds  = secondsSince (startTicks);
+    st.busySeconds  = st.wallSeconds - double (sleptTicks)
+                                     / double (juce::Time::getHighResolutionTicksPerSecond());
+    st.audioSeconds = audioSeconds;
+    st.bytesRead    = bytesRead;
+    st.bytesWritten = bytesWritten.load();
+    return st;
+}
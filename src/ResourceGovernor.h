@@ -0,0 +1,83 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include "ConversionJob.h"
+#include <atomic>
+#include <memory>
+
+// What a run actually achieved, reported whether or not limits were set.
+struct ThroughputStats
+{
+    double      wallSeconds  { 0.0 };
+    double      busySeconds  { 0.0 };   // wall time not spent throttled
+    double      audioSeconds { 0.0 };   // source audio processed
+    juce::int64 bytesRead    { 0 };
+    juce::int64 bytesWritten { 0 };
+
+    double busyPercent() const     { return wallSeconds > 0.0 ? 100.0 * busySeconds / wallSeconds : 0.0; }
+    double bytesPerSecond() const  { return wallSeconds > 0.0 ? double (bytesRead + bytesWritten) / wallSeconds : 0.0; }
+    double realtimeFactor() const  { return wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0; }
+};
+
+// Keeps a conversion run inside a CPU share and an I/O bandwidth budget by
+// sleeping between blocks. Everything the worker does outside those sleeps
+// counts as busy time, so file opens and finalisation are paid for as well.
+// Both budgets are token buckets holding at most kBurstSeconds of credit:
+// running under the cap for an hour still allows only a short burst after.
+class ResourceGovernor
+{
+public:
+    explicit ResourceGovernor (ResourceLimits limits);
+
+    // Drops the calling thread to the lowest CPU and I/O scheduling class the
+    // platform offers (nice 19 + idle I/O class on Linux, throttled I/O on macOS).
+    static void applyBackgroundScheduling();
+
+    // Call once per decoded block with the source bytes and audio it covered.
+    // Sleeps as long as needed to honour the limits, waking early on thread exit.
+    void blockDone (juce::int64 bytesRead, double audioSeconds);
+
+    ThroughputStats getStats() const;
+    const ResourceLimits& getLimits() const  { return limits; }
+
+    // Pass-through stream that adds every byte written to the governor's count.
+    class CountingStream : public juce::OutputStream
+    {
+    public:
+        CountingStream (std::unique_ptr<juce::OutputStream> inner, ResourceGovernor& g)
+            : dest (std::move (inner)), governor (g) {}
+
+        void  flush() override                          { dest->flush(); }
+        bool  setPosition (juce::int64 pos) override    { return dest->setPosition (pos); }
+        juce::int64 getPosition() override              { return dest->getPosition(); }
+
+        bool write (const void* data, size_t numBytes) override
+        {
+            governor.bytesWritten.fetch_add (juce::int64 (numBytes), std::memory_order_relaxed);
+            return dest->write (data, numBytes);
+        }
+
+    private:
+        std::unique_ptr<juce::OutputStream> dest;
+        ResourceGovernor& governor;
+
+        JUCE_DECLARE_NON_COPYABLE (CountingStream)
+    };
+
+private:
+    double secondsSince (juce::int64 ticks) const;
+
+    static constexpr double kBurstSeconds = 1.0;
+
+    const ResourceLimits     limits;
+    const juce::int64        startTicks;
+    juce::int64              lastTicks;             // end of the previous blockDone()
+    juce::int64              lastMoved    { 0 };    // bytes read + written at that point
+    double                   cpuCredit    { 0.0 };  // busy seconds that may still be spent
+    double                   ioCredit     { 0.0 };  // bytes that may still be moved
+    juce::int64              sleptTicks   { 0 };
+    juce::int64              bytesRead    { 0 };
+    double                   audioSeconds { 0.0 };
+    std::atomic<juce::int64> bytesWritten { 0 };    // output branches may run on other threads
+
+    JUCE_DECLARE_NON_COPYABLE (ResourceGovernor)
+};
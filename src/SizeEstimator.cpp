@@ -0,0 +1,259 @@
+#include "SizeEstimator.h"
+#include "ArchiveSource.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+
+namespace
+{
+    // Discards everything written to it but keeps a running byte count,
+    // which outlives the stream (the FLAC writer deletes it on finish).
+    class CountingOutputStream : public juce::OutputStream
+    {
+    public:
+        explicit CountingOutputStream (juce::int64& counter) : count (counter) {}
+
+        void flush() override                        {}
+        bool setPosition (juce::int64 p) override    { pos = p; return true; }
+        juce::int64 getPosition() override           { return pos; }
+
+        bool write (const void*, size_t numBytes) override
+        {
+            pos  += juce::int64 (numBytes);
+            count = juce::jmax (count, pos);
+            return true;
+        }
+
+    private:
+        juce::int64& count;
+        juce::int64  pos { 0 };
+    };
+}
+
+struct SizeEstimator::Session
+{
+    juce::CriticalSection lock;
+    BatchEstimate         total;
+    int                   remaining { 0 };
+    std::atomic<bool>     cancelled { false };
+    Callback              callback;
+};
+
+SizeEstimator::SizeEstimator()
+    : pool (juce::ThreadPoolOptions{}
+                .withThreadName ("Wav2FlacYeah Estimator")
+                // One per physical core, so no two timed encodes share a core
+                .withNumberOfThreads (juce::jmax (1, juce::SystemStats::getNumPhysicalCpus())))
+{
+    formatManager.registerBasicFormats();
+}
+
+SizeEstimator::~SizeEstimator()
+{
+    cancel();
+    pool.removeAllJobs (true, 4000);
+}
+
+void SizeEstimator::cancel()
+{
+    if (session != nullptr)
+        session->cancelled = true;
+    session.reset();
+}
+
+void SizeEstimator::start (const juce::Array<ConversionJob>& jobs,
+                           juce::Array<ConversionSettings>   profiles,
+                           ResourceLimits                    limits,
+                           Callback                          onFinished)
+{
+    cancel();
+    pool.removeAllJobs (false, 0);
+
+    auto sess       = std::make_shared<Session>();
+    sess->remaining = jobs.size();
+    sess->callback  = std::move (onFinished);
+    session         = sess;
+
+    auto finish = [] (std::shared_ptr<Session> s)
+    {
+        juce::MessageManager::callAsync ([s]
+        {
+            if (!s->cancelled)
+                s->callback (s->total);
+        });
+    };
+
+    if (jobs.isEmpty())
+    {
+        finish (sess);
+        return;
+    }
+
+    for (const auto& job : jobs)
+    {
+        pool.addJob ([this, sess, job, profiles, limits, finish]
+        {
+            if (sess->cancelled)
+                return;
+
+            const auto fe = estimateFile (job, profiles, limits);
+
+            juce::ScopedLock sl (sess->lock);
+            auto& t = sess->total;
+            ++t.numFiles;
+            if (fe.ok)
+            {
+                t.inputBytes    += fe.inputBytes;
+                t.bytesSampled  += fe.bytesSampled;
+                t.outputBytes   += fe.outputBytes;
+                t.encodeSeconds += fe.encodeSeconds;
+            }
+            else
+            {
+                ++t.numFailed;
+            }
+
+            if (--sess->remaining == 0)
+                finish (sess);
+        });
+    }
+}
+
+SizeEstimator::FileEstimate SizeEstimator::estimateFile (const ConversionJob&                   job,
+                                                         const juce::Array<ConversionSettings>& profiles,
+                                                         const ResourceLimits&                  limits)
+{
+    FileEstimate fe;
+
+    auto in = ArchiveSource::openInput (job);
+    if (in == nullptr)
+        return fe;
+    fe.inputBytes = in->getTotalLength();
+
+    auto reader = ArchiveSource::createReader (formatManager, std::move (in));
+
+    if (reader == nullptr || reader->lengthInSamples <= 0 || profiles.isEmpty())
+        return fe;
+
+    const double  srcRate   = reader->sampleRate;
+    const int     numCh     = int (reader->numChannels);
+    const int     srcBits   = int (reader->bitsPerSample);
+    const int64_t numFrames = reader->lengthInSamples;
+
+    // One writer per profile, all fed from the same decoded stretches
+    struct Branch
+    {
+        double      outRate      { 0.0 };
+        juce::int64 encodedBytes { 0 };
+        juce::int64 headerBytes  { 0 };   // fLaC marker, STREAMINFO, padding
+        double      seconds      { 0.0 }; // resample + encode time for the sampled stretches
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+    };
+
+    juce::OwnedArray<Branch> branches;
+    juce::FlacAudioFormat    flac;
+
+    for (const auto& s : profiles)
+    {
+        auto* b = branches.add (new Branch());
+        b->outRate = (s.targetSampleRate > 0) ? double (s.targetSampleRate) : srcRate;
+
+        auto countStream = std::make_unique<CountingOutputStream> (b->encodedBytes);
+        b->writer.reset (flac.createWriterFor (countStream.get(), b->outRate, unsigned (numCh),
+                                               s.outputBitDepth (srcBits), {}, s.flacQuality));
+        if (b->writer == nullptr)
+            return fe;
+        countStream.release(); // writer now owns the stream
+
+        b->headerBytes = b->encodedBytes;
+    }
+
+    // Short files are encoded whole; longer ones as evenly spaced stretches.
+    // A compressed archive entry can only seek by decompressing everything
+    // before the target, so it gets the same amount of audio from the start.
+    int64_t stretchLen  = juce::jmax (int64_t (1024), int64_t (srcRate * kStretchSecs));
+    int     numStretches = kNumStretches;
+    if (numFrames <= stretchLen * kNumStretches * 2)
+    {
+        stretchLen   = numFrames;
+        numStretches = 1;
+    }
+    else if (job.archiveLocation.compressed)
+    {
+        stretchLen  *= kNumStretches;
+        numStretches = 1;
+    }
+
+    auto secondsSince = [] (juce::int64 ticks)
+    {
+        return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - ticks);
+    };
+
+    juce::AudioBuffer<float> stretch (numCh, int (stretchLen));
+    int64_t sampledFrames = 0;
+
+    for (int k = 0; k < numStretches; ++k)
+    {
+        const int64_t start = (numStretches == 1) ? 0
+                            : (numFrames - stretchLen) * k / (numStretches - 1);
+        const int n = int (stretchLen);
+
+        // Not timed: seeking to scattered stretches says nothing about a sequential read
+        reader->read (&stretch, 0, n, start, true, true);
+        sampledFrames += n;
+
+        for (auto* b : branches)
+        {
+            const auto t0 = juce::Time::getHighResolutionTicks();
+
+            if (b->outRate == srcRate)
+            {
+                b->writer->writeFromAudioSampleBuffer (stretch, 0, n);
+            }
+            else
+            {
+                juce::MemoryAudioSource     memSrc (stretch, false, false);
+                juce::ResamplingAudioSource resampler (&memSrc, false, numCh);
+                resampler.setResamplingRatio (srcRate / b->outRate);
+
+                const int outN = int (double (n) * b->outRate / srcRate + 0.5);
+                resampler.prepareToPlay (outN, b->outRate);
+
+                juce::AudioBuffer<float> resampled (numCh, outN);
+                juce::AudioSourceChannelInfo info (&resampled, 0, outN);
+                resampler.getNextAudioBlock (info);
+                resampler.releaseResources();
+
+                b->writer->writeFromAudioSampleBuffer (resampled, 0, outN);
+            }
+
+            b->seconds += secondsSince (t0);
+        }
+    }
+
+    const double scale = double (numFrames) / double (sampledFrames);
+    double encodeSeconds = 0.0;
+
+    for (auto* b : branches)
+    {
+        const auto t0 = juce::Time::getHighResolutionTicks();
+        b->writer.reset(); // flush the final frames into the count
+        b->seconds += secondsSince (t0);
+
+        fe.outputBytes += b->headerBytes + juce::int64 (double (b->encodedBytes - b->headerBytes) * scale);
+
+        // Branches share the pool, except in background mode where they take turns
+        encodeSeconds = limits.isBackground() ? encodeSeconds + b->seconds * scale
+                                              : juce::jmax (encodeSeconds, b->seconds * scale);
+    }
+
+    if (limits.cpuPercent < 100)
+        encodeSeconds *= 100.0 / double (juce::jmax (1, limits.cpuPercent));
+
+    if (limits.ioBytesPerSecond > 0)
+        encodeSeconds = juce::jmax (encodeSeconds, double (fe.inputBytes + fe.outputBytes)
+                                                   / double (limits.ioBytesPerSecond));
+
+    fe.ok            = true;
+    fe.bytesSampled  = sampledFrames * numCh * (srcBits / 8);
+    fe.encodeSeconds = encodeSeconds;
+    return fe;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_events/juce_events.h>
+#include <juce_core/juce_core.h>
+#include "ConversionJob.h"
+#include <functional>
+#include <memory>
+
+struct BatchEstimate
+{
+    juce::int64 inputBytes    { 0 };
+    juce::int64 bytesSampled  { 0 };    // input bytes actually read to make the estimate
+    juce::int64 outputBytes   { 0 };    // extrapolated total FLAC size
+    double      encodeSeconds { 0.0 };  // extrapolated resample + encode time for one worker, excluding I/O
+    int         numFiles      { 0 };
+    int         numFailed     { 0 };
+};
+
+// Pre-flight estimate of output size and conversion time. Decodes a few short
+// stretches of every queued file once, encodes them for each output profile on
+// a thread pool and extrapolates to the full length, so only a small fraction
+// of each input is read. Only resampling and encoding are timed; the time
+// accounts for background limits the way the conversion applies them.
+class SizeEstimator
+{
+public:
+    using Callback = std::function<void (const BatchEstimate&)>;
+
+    SizeEstimator();
+    ~SizeEstimator();
+
+    // Cancels any estimate in flight. The callback runs on the message thread.
+    void start (const juce::Array<ConversionJob>& jobs,
+                juce::Array<ConversionSettings>   profiles,
+                ResourceLimits                    limits,
+                Callback                          onFinished);
+
+    void cancel();
+
+private:
+    struct FileEstimate
+    {
+        bool        ok            { false };
+        juce::int64 inputBytes    { 0 };
+        juce::int64 bytesSampled  { 0 };
+        juce::int64 outputBytes   { 0 };
+        double      encodeSeconds { 0.0 };
+    };
+
+    struct Session;
+
+    FileEstimate estimateFile (const ConversionJob&                   job,
+                               const juce::Array<ConversionSettings>& profiles,
+                               const ResourceLimits&                  limits);
+
+    static constexpr int    kNumStretches  = 8;
+    static constexpr double kStretchSecs   = 0.5;
+
+    juce::AudioFormatManager formatManager;
+    juce::ThreadPool         pool;
+    std::shared_ptr<Session> session;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SizeEstimator)
+};
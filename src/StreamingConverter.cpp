@@ -0,0 +1,484 @@
+#include "StreamingConverter.h"
+#include "BlockGeometry.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cstring>
+
+#if JUCE_WINDOWS
+ #include <fcntl.h>
+ #include <io.h>
+#endif
+
+// ─── StdioInputStream ────────────────────────────────────────────────────────
+int StdioInputStream::read (void* dest, int numBytes)
+{
+    const auto n = std::fread (dest, 1, size_t (numBytes), file);
+    position += juce::int64 (n);
+    return int (n);
+}
+
+bool StdioInputStream::setPosition (juce::int64 newPos)
+{
+    if (newPos < position)
+        return false;
+
+    char scratch[4096];
+    while (position < newPos)
+        if (read (scratch, int (juce::jmin (juce::int64 (sizeof (scratch)), newPos - position))) <= 0)
+            return false;
+
+    return true;
+}
+
+// ─── StdioOutputStream ───────────────────────────────────────────────────────
+bool StdioOutputStream::setPosition (juce::int64 newPos)
+{
+    if (newPos == position)
+        return true;
+
+    if (canSeek)
+    {
+       #if JUCE_WINDOWS
+        const bool ok = _fseeki64 (file, newPos, SEEK_SET) == 0;
+       #else
+        const bool ok = fseeko (file, off_t (newPos), SEEK_SET) == 0;
+       #endif
+
+        if (ok)
+        {
+            position = newPos;
+            return true;
+        }
+
+        canSeek = false;
+    }
+
+    // Forward-only handle: only positions inside the emitted bytes make sense,
+    // and anything written there is dropped until we catch up again
+    if (newPos > emitted)
+        return false;
+
+    position = newPos;
+    return true;
+}
+
+bool StdioOutputStream::write (const void* data, size_t numBytes)
+{
+    auto* src = static_cast<const char*> (data);
+
+    if (!canSeek && position < emitted)
+    {
+        const auto overlap = size_t (juce::jmin (juce::int64 (numBytes), emitted - position));
+        src      += overlap;
+        numBytes -= overlap;
+        position += juce::int64 (overlap);
+    }
+
+    if (numBytes > 0 && std::fwrite (src, 1, numBytes, file) != numBytes)
+        return false;
+
+    position += juce::int64 (numBytes);
+    emitted   = juce::jmax (emitted, position);
+    return true;
+}
+
+// ─── StreamingWavReader ──────────────────────────────────────────────────────
+StreamingWavReader::StreamingWavReader (juce::InputStream& source)
+    : in (source)
+{
+}
+
+bool StreamingWavReader::readExactly (void* dest, int numBytes)
+{
+    auto* d = static_cast<char*> (dest);
+    while (numBytes > 0)
+    {
+        const int n = in.read (d, numBytes);
+        if (n <= 0)
+            return false;
+        d        += n;
+        numBytes -= n;
+    }
+    return true;
+}
+
+bool StreamingWavReader::skip (juce::int64 numBytes)
+{
+    return in.setPosition (in.getPosition() + numBytes);
+}
+
+bool StreamingWavReader::parseHeader()
+{
+    char riff[12];
+    if (!readExactly (riff, 12))
+    {
+        error = "Input is empty";
+        return false;
+    }
+
+    const bool isRF64 = juce::String (riff, 4) == "RF64";
+    if ((juce::String (riff, 4) != "RIFF" && !isRF64) || juce::String (riff + 8, 4) != "WAVE")
+    {
+        error = "Input is not a WAV stream";
+        return false;
+    }
+
+    juce::int64 ds64DataSize = -1;
+    int formatTag = 0;
+
+    for (;;)
+    {
+        char hdr[8];
+        if (!readExactly (hdr, 8))
+        {
+            error = "No data chunk in WAV stream";
+            return false;
+        }
+
+        const juce::String id (hdr, 4);
+        const auto size = juce::int64 (juce::ByteOrder::littleEndianInt (hdr + 4));
+
+        if (id == "data")
+        {
+            if (formatTag == 0)
+            {
+                error = "WAV data chunk before fmt chunk";
+                return false;
+            }
+
+            // 0 and 0xFFFFFFFF are what writers put down when they don't know
+            // the length up front; treat both as "until EOF"
+            if (isRF64 && size == 0xffffffff)
+                bytesLeft = ds64DataSize > 0 ? ds64DataSize : -1;
+            else
+                bytesLeft = (size == 0 || size == 0xffffffff) ? -1 : size;
+            dataBytes = bytesLeft;
+            break;
+        }
+
+        const auto padded = size + (size & 1);
+        char body[64] = {};
+        const int  take = int (juce::jmin (padded, juce::int64 (sizeof (body))));
+
+        if (!readExactly (body, take) || !skip (padded - take))
+        {
+            error = "Truncated WAV header";
+            return false;
+        }
+
+        if (id == "ds64" && take >= 24)
+        {
+            ds64DataSize = juce::int64 (juce::ByteOrder::littleEndianInt64 (body + 8));
+        }
+        else if (id == "fmt " && take >= 16)
+        {
+            formatTag     = juce::ByteOrder::littleEndianShort (body);
+            numChannels   = juce::ByteOrder::littleEndianShort (body + 2);
+            sampleRate    = double (juce::ByteOrder::littleEndianInt (body + 4));
+            bitsPerSample = juce::ByteOrder::littleEndianShort (body + 14);
+
+            if (formatTag == 0xfffe && take >= 26) // WAVE_FORMAT_EXTENSIBLE: sub-format GUID
+                formatTag = juce::ByteOrder::littleEndianShort (body + 24);
+        }
+    }
+
+    isFloat = (formatTag == 3);
+    const bool intOk   = formatTag == 1 && (bitsPerSample == 8  || bitsPerSample == 16
+                                         || bitsPerSample == 24 || bitsPerSample == 32);
+    const bool floatOk = isFloat && (bitsPerSample == 32 || bitsPerSample == 64);
+
+    if ((!intOk && !floatOk) || numChannels <= 0 || sampleRate <= 0.0)
+    {
+        error = "Unsupported WAV format (tag " + juce::String (formatTag)
+              + ", " + juce::String (bitsPerSample) + "-bit)";
+        return false;
+    }
+
+    return true;
+}
+
+int StreamingWavReader::readFrames (juce::AudioBuffer<float>& dest, int startFrame, int maxFrames)
+{
+    const int bytesPerSample = bitsPerSample / 8;
+    const int bytesPerFrame  = bytesPerSample * numChannels;
+
+    if (bytesLeft >= 0)
+        maxFrames = int (juce::jmin (juce::int64 (maxFrames), bytesLeft / bytesPerFrame));
+
+    if (maxFrames <= 0)
+        return 0;
+
+    if (rawFrames < maxFrames)
+    {
+        raw.realloc (size_t (maxFrames) * size_t (bytesPerFrame));
+        rawFrames = maxFrames;
+    }
+
+    // A pipe may deliver less than asked for; keep reading until full or EOF
+    int got = 0;
+    const int wanted = maxFrames * bytesPerFrame;
+    while (got < wanted)
+    {
+        const int n = in.read (raw + got, wanted - got);
+        if (n <= 0)
+            break;
+        got += n;
+    }
+
+    const int frames = got / bytesPerFrame; // a trailing partial frame is dropped
+    if (bytesLeft >= 0)
+        bytesLeft -= juce::int64 (frames) * bytesPerFrame;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* out = dest.getWritePointer (ch, startFrame);
+        const char* p = raw + ch * bytesPerSample;
+
+        for (int f = 0; f < frames; ++f, p += bytesPerFrame)
+        {
+            float v = 0.0f;
+            if (isFloat)
+            {
+                if (bitsPerSample == 32)
+                {
+                    const auto bits = juce::ByteOrder::littleEndianInt (p);
+                    std::memcpy (&v, &bits, sizeof (v));
+                }
+                else
+                {
+                    const auto bits = juce::ByteOrder::littleEndianInt64 (p);
+                    double d;
+                    std::memcpy (&d, &bits, sizeof (d));
+                    v = float (d);
+                }
+            }
+            else
+            {
+                switch (bitsPerSample)
+                {
+                    case 8:  v = float (int (static_cast<juce::uint8> (*p)) - 128) / 128.0f;                       break;
+                    case 16: v = float (static_cast<juce::int16> (juce::ByteOrder::littleEndianShort (p))) / 32768.0f; break;
+                    case 24: v = float (juce::ByteOrder::littleEndian24Bit (p)) / 8388608.0f;                      break;
+                    default: v = float (static_cast<juce::int32> (juce::ByteOrder::littleEndianInt (p))) / 2147483648.0f; break;
+                }
+            }
+            out[f] = v;
+        }
+    }
+
+    return frames;
+}
+
+// ─── Conversion ──────────────────────────────────────────────────────────────
+namespace
+{
+    // Pulls frames from the stream on demand, so the resampler can run over a
+    // source of unknown length. Pads with silence after EOF.
+    class StreamingWavSource : public juce::AudioSource
+    {
+    public:
+        explicit StreamingWavSource (StreamingWavReader& r) : reader (r) {}
+
+        void prepareToPlay (int, double) override {}
+        void releaseResources() override {}
+
+        void getNextAudioBlock (const juce::AudioSourceChannelInfo& info) override
+        {
+            int filled = 0;
+            while (!exhausted && filled < info.numSamples)
+            {
+                const int n = reader.readFrames (*info.buffer, info.startSample + filled,
+                                                 info.numSamples - filled);
+                if (n == 0)
+                    exhausted = true;
+                filled         += n;
+                framesDelivered += n;
+            }
+
+            if (filled < info.numSamples)
+                info.buffer->clear (info.startSample + filled, info.numSamples - filled);
+        }
+
+        bool        exhausted       { false };
+        juce::int64 framesDelivered { 0 };
+
+    private:
+        StreamingWavReader& reader;
+    };
+
+    int fail (const juce::String& message)
+    {
+        std::fprintf (stderr, "wav2flac: %s\n", message.toRawUTF8());
+        return 1;
+    }
+}
+
+namespace StreamingConverter
+{
+std::optional<Options> parseCommandLine (const juce::StringArray& args)
+{
+    Options o;
+    juce::StringArray positional;
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& a = args[i];
+
+        if (a == "--rate" || a == "--bits" || a == "--level")
+        {
+            if (i + 1 >= args.size())
+                return std::nullopt;
+
+            const int v = args[++i].getIntValue();
+            if (a == "--rate")       o.settings.targetSampleRate = v;
+            else if (a == "--bits")  o.settings.targetBitDepth   = v;
+            else                     o.settings.flacQuality      = juce::jlimit (0, 8, v);
+        }
+        else if (a == "-o" || a == "--output")
+        {
+            if (i + 1 >= args.size() || o.outputPath.isNotEmpty())
+                return std::nullopt;
+
+            o.outputPath = args[++i];
+        }
+        else if (a == "-" || !a.startsWith ("-"))
+        {
+            positional.add (a);
+        }
+        else
+        {
+            return std::nullopt;
+        }
+    }
+
+    if (positional.size() != 1 || o.outputPath.isEmpty())
+        return std::nullopt;
+
+    o.inputPath = positional[0];
+    return o;
+}
+
+int run (const Options& o)
+{
+   #if JUCE_WINDOWS
+    _setmode (_fileno (stdin),  _O_BINARY);
+    _setmode (_fileno (stdout), _O_BINARY);
+   #endif
+
+    const auto cwd = juce::File::getCurrentWorkingDirectory();
+    const bool toStdout = (o.outputPath == "-");
+
+    if (!toStdout)
+    {
+        const auto target = cwd.getChildFile (o.outputPath);
+        if (target.exists() && !target.hasFileExtension ("flac"))
+            return fail ("Refusing to overwrite " + target.getFullPathName() + " (not a .flac file)");
+    }
+
+    std::unique_ptr<juce::InputStream> in;
+    if (o.inputPath == "-")
+        in = std::make_unique<StdioInputStream> (stdin);
+    else
+        in = cwd.getChildFile (o.inputPath).createInputStream();
+
+    if (in == nullptr)
+        return fail ("Cannot read: " + o.inputPath);
+
+    StreamingWavReader wav (*in);
+    if (!wav.parseHeader())
+        return fail (wav.error);
+
+    const auto&  s       = o.settings;
+    const double srcRate = wav.sampleRate;
+    const int    numCh   = wav.numChannels;
+    const double outRate = (s.targetSampleRate > 0) ? double (s.targetSampleRate) : srcRate;
+    const int    outBits = s.outputBitDepth (wav.bitsPerSample);
+
+    const auto geometry = BlockGeometryProfile::lookup (numCh, wav.bitsPerSample);
+
+    std::unique_ptr<juce::OutputStream> outStream;
+    if (toStdout)
+    {
+        outStream = std::make_unique<StdioOutputStream> (stdout);
+    }
+    else
+    {
+        auto fileStream = std::make_unique<juce::FileOutputStream> (cwd.getChildFile (o.outputPath),
+                                                                   size_t (geometry.writeBufferBytes));
+        if (fileStream->failedToOpen())
+            return fail ("Cannot write: " + o.outputPath);
+        fileStream->setPosition (0);
+        fileStream->truncate();
+        outStream = std::move (fileStream);
+    }
+
+    auto* out = outStream.get();
+
+    juce::FlacAudioFormat flac;
+    std::unique_ptr<juce::AudioFormatWriter> writer (
+        flac.createWriterFor (out, outRate, unsigned (numCh), outBits, {}, s.flacQuality));
+
+    if (writer == nullptr)
+        return fail ("FLAC writer failed (bit depth " + juce::String (outBits) + " unsupported?)");
+    outStream.release(); // writer now owns the stream
+
+    const int blockSize = geometry.blockFrames;
+    juce::AudioBuffer<float> block (numCh, blockSize);
+
+    if (outRate == srcRate)
+    {
+        for (;;)
+        {
+            const int n = wav.readFrames (block, 0, blockSize);
+            if (n == 0)
+                break;
+
+            if (!writer->writeFromAudioSampleBuffer (block, 0, n))
+                return fail ("Write error");
+
+            if (toStdout)
+                out->flush(); // keep pipeline latency to one block
+        }
+    }
+    else
+    {
+        StreamingWavSource src (wav);
+        juce::ResamplingAudioSource resampler (&src, false, numCh);
+        resampler.setResamplingRatio (srcRate / outRate);
+        resampler.prepareToPlay (blockSize, outRate);
+
+        juce::int64 written = 0;
+
+        for (;;)
+        {
+            juce::AudioSourceChannelInfo info (&block, 0, blockSize);
+            resampler.getNextAudioBlock (info);
+
+            // Once the input has ended, stop at the length it maps to
+            int n = blockSize;
+            if (src.exhausted)
+            {
+                const auto outFrames = juce::int64 (double (src.framesDelivered) * outRate / srcRate + 0.5);
+                n = int (juce::jlimit (juce::int64 (0), juce::int64 (blockSize), outFrames - written));
+            }
+
+            if (n > 0 && !writer->writeFromAudioSampleBuffer (block, 0, n))
+                return fail ("Write error during resample");
+
+            written += n;
+
+            if (toStdout)
+                out->flush();
+
+            if (n < blockSize)
+                break;
+        }
+
+        resampler.releaseResources();
+    }
+
+    // Finishing rewrites STREAMINFO in place when the output can seek; on a
+    // pipe StdioOutputStream drops the rewrite and the streaming header stands
+    writer.reset();
+    return 0;
+}
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_core/juce_core.h>
+#include "ConversionJob.h"
+#include <cstdio>
+#include <optional>
+
+// Command-line streaming mode for shell pipelines:
+//
+//     wav2flac [--rate N] [--bits N] [--level N] <in.wav|-> -o <out.flac|->
+//
+// "-" means stdin / stdout. The -o switch is required, so launching the app
+// on two files (drag and drop, "Open with") never turns into a conversion
+// that writes over the second one. An existing output is only replaced if it
+// is a .flac file. The input is parsed as it arrives, so WAV streams
+// whose data size is 0 or 0xFFFFFFFF (length unknown when the header was
+// written) are read until EOF. Memory use is one block regardless of length.
+namespace StreamingConverter
+{
+    struct Options
+    {
+        juce::String       inputPath;
+        juce::String       outputPath;
+        ConversionSettings settings;
+    };
+
+    // Returns the parsed options when the command line asks for streaming mode.
+    std::optional<Options> parseCommandLine (const juce::StringArray& args);
+
+    // Runs the conversion and returns a process exit code.
+    int run (const Options& options);
+}
+
+// juce::InputStream over a C stdio handle. Not seekable, apart from skipping
+// forward, so it works on pipes.
+class StdioInputStream : public juce::InputStream
+{
+public:
+    explicit StdioInputStream (FILE* f) : file (f) {}
+
+    juce::int64 getTotalLength() override   { return -1; }
+    bool isExhausted() override             { return std::feof (file) != 0; }
+    juce::int64 getPosition() override      { return position; }
+    int read (void* dest, int numBytes) override;
+    bool setPosition (juce::int64 newPos) override;
+
+private:
+    FILE*       file;
+    juce::int64 position { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (StdioInputStream)
+};
+
+// juce::OutputStream over a C stdio handle. When the handle can't seek (a pipe),
+// seeks back into already-emitted bytes are accepted but the rewritten bytes
+// are dropped. The FLAC writer uses exactly that to patch STREAMINFO on finish,
+// so on a pipe the original header - with total samples and MD5 left as 0,
+// meaning "unknown" - is what goes out, which is the streaming form of FLAC.
+class StdioOutputStream : public juce::OutputStream
+{
+public:
+    explicit StdioOutputStream (FILE* f) : file (f) {}
+    ~StdioOutputStream() override           { flush(); }
+
+    void flush() override                   { std::fflush (file); }
+    juce::int64 getPosition() override      { return position; }
+    bool setPosition (juce::int64 newPos) override;
+    bool write (const void* data, size_t numBytes) override;
+
+private:
+    FILE*       file;
+    juce::int64 position { 0 };    // logical write position
+    juce::int64 emitted  { 0 };    // bytes actually written to the handle
+    bool        canSeek  { true }; // cleared on the first failed seek
+
+    JUCE_DECLARE_NON_COPYABLE (StdioOutputStream)
+};
+
+// Incremental WAV parser that never seeks: reads RIFF / RF64 headers up to the
+// data chunk and then hands out float frames until the data size or EOF.
+class StreamingWavReader
+{
+public:
+    explicit StreamingWavReader (juce::InputStream& source);
+
+    bool   parseHeader();               // false if not a supported WAV stream
+    int    readFrames (juce::AudioBuffer<float>& dest, int startFrame, int maxFrames);
+
+    double       sampleRate    { 0.0 };
+    int          numChannels   { 0 };
+    int          bitsPerSample { 0 };
+    bool         isFloat       { false };
+    juce::int64  dataBytes     { -1 };      // data chunk size; -1 if the header doesn't know
+    juce::String error;
+
+private:
+    juce::InputStream&   in;
+    juce::int64          bytesLeft { -1 };   // -1: unknown, read to EOF
+    juce::HeapBlock<char> raw;
+    int                  rawFrames { 0 };
+
+    bool readExactly (void* dest, int numBytes);
+    bool skip        (juce::int64 numBytes);
+};
@@ -0,0 +1,210 @@
+#include "TraceRecorder.h"
+#include <juce_events/juce_events.h>
+
+namespace TraceRecorder
+{
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        juce::int64 start;
+        juce::int64 end;
+    };
+
+    // One per recording thread. Only the owning thread writes `events` and
+    // `count`; stop() reads the published prefix. When the thread exits the
+    // buffer stays registered (stop() may still need its spans) and goes on
+    // the free list, to be handed to a thread of a later session.
+    struct ThreadBuffer
+    {
+        static constexpr int capacity = 1 << 18;
+
+        std::unique_ptr<Event[]>   events { new Event[capacity] };
+        std::atomic<int>           count      { 0 };
+        std::atomic<int>           dropped    { 0 };
+        std::atomic<juce::uint32>  generation { 0 };
+        int                        tid        { 0 };
+        juce::String               threadName;
+    };
+
+    std::atomic<juce::uint32> currentGeneration { 0 };
+    std::atomic<juce::int64>  sessionStartTicks { 0 };
+
+    juce::CriticalSection& getRegistryLock()
+    {
+        static juce::CriticalSection cs;
+        return cs;
+    }
+
+    juce::OwnedArray<ThreadBuffer>& getRegistry()
+    {
+        static juce::OwnedArray<ThreadBuffer> buffers;
+        return buffers;
+    }
+
+    juce::Array<ThreadBuffer*>& getFreeList()
+    {
+        static juce::Array<ThreadBuffer*> freeBuffers;
+        return freeBuffers;
+    }
+
+    // Returns the thread's buffer to the free list when the thread exits
+    struct LocalBufferOwner
+    {
+        ThreadBuffer* buffer { nullptr };
+
+        ~LocalBufferOwner()
+        {
+            if (buffer != nullptr)
+            {
+                juce::ScopedLock sl (getRegistryLock());
+                getFreeList().add (buffer);
+            }
+        }
+    };
+
+    thread_local LocalBufferOwner localBuffer;
+
+    ThreadBuffer& getLocalBuffer()
+    {
+        if (localBuffer.buffer == nullptr)
+        {
+            juce::String threadName;
+
+            if (auto* t = juce::Thread::getCurrentThread())
+                threadName = t->getThreadName();
+            else if (juce::MessageManager::getInstanceWithoutCreating() != nullptr
+                     && juce::MessageManager::getInstanceWithoutCreating()->isThisTheMessageThread())
+                threadName = "Message Thread";
+
+            const auto gen = currentGeneration.load (std::memory_order_acquire);
+
+            juce::ScopedLock sl (getRegistryLock());
+            ThreadBuffer* b = nullptr;
+
+            // A freed buffer that still holds this session's spans must survive until stop()
+            for (auto* f : getFreeList())
+            {
+                if (f->generation.load (std::memory_order_relaxed) != gen)
+                {
+                    b = f;
+                    getFreeList().removeFirstMatchingValue (f);
+                    break;
+                }
+            }
+
+            if (b == nullptr)
+            {
+                b = getRegistry().add (new ThreadBuffer());
+                b->tid = getRegistry().size();
+            }
+
+            b->threadName = threadName.isNotEmpty() ? threadName : "Thread " + juce::String (b->tid);
+            localBuffer.buffer = b;
+        }
+        return *localBuffer.buffer;
+    }
+
+    void writeEscaped (juce::OutputStream& out, const juce::String& s)
+    {
+        out << '"' << juce::JSON::escapeString (s) << '"';
+    }
+}
+
+void start()
+{
+    sessionStartTicks.store (juce::Time::getHighResolutionTicks());
+    currentGeneration.fetch_add (1, std::memory_order_release);
+    enabled.store (true);
+}
+
+void record (const char* name, juce::int64 startTicks, juce::int64 endTicks)
+{
+    if (!isEnabled())
+        return;
+
+    auto& b = getLocalBuffer();
+    const auto gen = currentGeneration.load (std::memory_order_acquire);
+
+    if (b.generation.load (std::memory_order_relaxed) != gen)
+    {
+        b.count.store (0, std::memory_order_relaxed);
+        b.dropped.store (0, std::memory_order_relaxed);
+        b.generation.store (gen, std::memory_order_release);
+    }
+
+    const int i = b.count.load (std::memory_order_relaxed);
+    if (i >= ThreadBuffer::capacity)
+    {
+        b.dropped.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+
+    b.events[i] = { name, startTicks, endTicks };
+    b.count.store (i + 1, std::memory_order_release);
+}
+
+bool stop (const juce::File& outputFile)
+{
+    enabled.store (false);
+
+    const auto   gen       = currentGeneration.load (std::memory_order_acquire);
+    const auto   base      = sessionStartTicks.load();
+    const double usPerTick = 1.0e6 / double (juce::Time::getHighResolutionTicksPerSecond());
+
+    juce::FileOutputStream out (outputFile);
+    if (out.failedToOpen())
+        return false;
+    out.setPosition (0);
+    out.truncate();
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+
+    auto separator = [&]
+    {
+        if (!first) out << ",\n";
+        first = false;
+    };
+
+    juce::ScopedLock sl (getRegistryLock());
+
+    for (auto* b : getRegistry())
+    {
+        if (b->generation.load (std::memory_order_acquire) != gen)
+            continue;
+
+        const int n = b->count.load (std::memory_order_acquire);
+
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->tid
+            << ",\"args\":{\"name\":";
+        writeEscaped (out, b->threadName);
+        out << "}}";
+
+        for (int i = 0; i < n; ++i)
+        {
+            const auto& e = b->events[i];
+            separator();
+            out << "{\"name\":";
+            writeEscaped (out, e.name);
+            out << ",\"cat\":\"convert\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid
+                << ",\"ts\":"  << juce::String (double (e.start - base) * usPerTick, 3)
+                << ",\"dur\":" << juce::String (double (e.end - e.start) * usPerTick, 3)
+                << "}";
+        }
+
+        if (const int dropped = b->dropped.load (std::memory_order_relaxed); dropped > 0)
+        {
+            separator();
+            out << "{\"name\":\"spans dropped\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" << b->tid
+                << ",\"ts\":0,\"args\":{\"count\":" << dropped << "}}";
+        }
+    }
+
+    out << "]}\n";
+    out.flush();
+    return out.getStatus().wasOk();
+}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <memory>
+
+// Scoped-span recorder for the conversion hot path.
+//
+// Off by default: a span then costs a single relaxed atomic load. While
+// recording, every thread appends to its own fixed-size buffer without taking
+// a lock, and stop() dumps all spans as Chrome trace-event JSON that can be
+// opened in chrome://tracing or ui.perfetto.dev.
+namespace TraceRecorder
+{
+    inline std::atomic<bool> enabled { false };
+
+    inline bool isEnabled() noexcept   { return enabled.load (std::memory_order_relaxed); }
+
+    // Discards spans from any previous session and starts recording.
+    void start();
+
+    // Stops recording and writes the session to outputFile. Returns false if
+    // the file could not be written.
+    bool stop (const juce::File& outputFile);
+
+    // Appends one completed span to the calling thread's buffer. `name` must
+    // be a string literal (only the pointer is stored).
+    void record (const char* name, juce::int64 startTicks, juce::int64 endTicks);
+
+    class ScopedSpan
+    {
+    public:
+        explicit ScopedSpan (const char* spanName) noexcept
+            : name (spanName), active (isEnabled())
+        {
+            if (active)
+                startTicks = juce::Time::getHighResolutionTicks();
+        }
+
+        ~ScopedSpan()
+        {
+            if (active)
+                record (name, startTicks, juce::Time::getHighResolutionTicks());
+        }
+
+    private:
+        const char* name;
+        bool        active;
+        juce::int64 startTicks { 0 };
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedSpan)
+    };
+
+    // Pass-through stream that records a "write" span around every write to
+    // the wrapped stream. Only installed while a session is recording.
+    class TracingOutputStream : public juce::OutputStream
+    {
+    public:
+        explicit TracingOutputStream (std::unique_ptr<juce::OutputStream> inner)
+            : dest (std::move (inner)) {}
+
+        void  flush() override                          { ScopedSpan s ("write"); dest->flush(); }
+        bool  setPosition (juce::int64 pos) override    { return dest->setPosition (pos); }
+        juce::int64 getPosition() override              { return dest->getPosition(); }
+
+        bool write (const void* data, size_t numBytes) override
+        {
+            ScopedSpan s ("write");
+            return dest->write (data, numBytes);
+        }
+
+    private:
+        std::unique_ptr<juce::OutputStream> dest;
+
+        JUCE_DECLARE_NON_COPYABLE (TracingOutputStream)
+    };
+}
+
+#define W2F_TRACE_SPAN(spanName) \
+    TraceRecorder::ScopedSpan JUCE_JOIN_MACRO (traceSpan_, __LINE__) (spanName)